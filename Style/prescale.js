@@ -0,0 +1,81 @@
+const puppeteer = require('puppeteer');
+const fs = require('fs');
+const path = require('path');
+
+// 背景图片预缩放脚本
+// 用法: node prescale.js -   标准输入为JSON: {jobs: [{src, out, width, height, quality}]}
+// 每张图片按"覆盖"目标尺寸所需的最小比例缩小（不放大、不裁剪），再编码为WebP
+
+function readStdin() {
+    return new Promise((resolve, reject) => {
+        const chunks = [];
+        process.stdin.on('data', chunk => chunks.push(chunk));
+        process.stdin.on('end', () => resolve(Buffer.concat(chunks).toString('utf8')));
+        process.stdin.on('error', reject);
+    });
+}
+
+const mimeTypes = {
+    '.png': 'image/png',
+    '.jpg': 'image/jpeg',
+    '.jpeg': 'image/jpeg',
+    '.gif': 'image/gif',
+    '.webp': 'image/webp'
+};
+
+(async () => {
+    if (process.argv[2] !== '-') {
+        console.error('用法: node prescale.js -  （从标准输入读取任务）');
+        process.exit(1);
+    }
+
+    let jobs;
+    try {
+        jobs = JSON.parse(await readStdin()).jobs || [];
+    } catch (e) {
+        console.error(`错误：无法解析标准输入中的任务: ${e.message}`);
+        process.exit(1);
+    }
+
+    const browser = await puppeteer.launch({
+        headless: 'new',
+        args: ['--no-sandbox', '--disable-setuid-sandbox']
+    });
+    const page = await browser.newPage();
+
+    let failed = 0;
+    for (const job of jobs) {
+        try {
+            const mime = mimeTypes[path.extname(job.src).toLowerCase()] || 'application/octet-stream';
+            const source = `data:${mime};base64,${fs.readFileSync(job.src).toString('base64')}`;
+
+            const dataUrl = await page.evaluate(async (src, width, height, quality) => {
+                const img = new Image();
+                img.src = src;
+                await img.decode();
+
+                const scale = Math.min(1, Math.max(width / img.naturalWidth, height / img.naturalHeight));
+                const canvas = document.createElement('canvas');
+                canvas.width = Math.max(1, Math.round(img.naturalWidth * scale));
+                canvas.height = Math.max(1, Math.round(img.naturalHeight * scale));
+
+                const ctx = canvas.getContext('2d');
+                ctx.imageSmoothingQuality = 'high';
+                ctx.drawImage(img, 0, 0, canvas.width, canvas.height);
+                return canvas.toDataURL('image/webp', quality / 100);
+            }, source, job.width, job.height, job.quality);
+
+            // 先写临时文件再重命名，避免截图时读到写了一半的缓存
+            const tmpPath = `${job.out}.${process.pid}.tmp`;
+            fs.writeFileSync(tmpPath, Buffer.from(dataUrl.split(',')[1], 'base64'));
+            fs.renameSync(tmpPath, job.out);
+            console.log(`已缩放: ${path.basename(job.src)} -> ${path.basename(job.out)}`);
+        } catch (e) {
+            failed++;
+            console.error(`缩放失败: ${job.src}: ${e.message}`);
+        }
+    }
+
+    await browser.close();
+    process.exit(failed === jobs.length && jobs.length > 0 ? 1 : 0);
+})();
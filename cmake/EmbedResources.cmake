@@ -0,0 +1,35 @@
+# 将默认主题文件嵌入为 constexpr 字节数组
+# 用法: cmake -DOUTPUT=<header> -DSOURCE_DIR=<dir> -DFILES=<a|b|c> -P EmbedResources.cmake
+
+string(REPLACE "|" ";" EMBED_FILES "${FILES}")
+# CMake正则不支持{n}，展开为16个字节的模式
+string(REPEAT "0x[0-9a-f][0-9a-f]," 16 EMBED_LINE_PATTERN)
+
+set(CONTENT "// 由 cmake/EmbedResources.cmake 生成，请勿手动修改\n")
+string(APPEND CONTENT "#pragma once\n\n#include <string_view>\n\nnamespace Yume::embedded {\n")
+
+set(TABLE "")
+foreach (EMBED_FILE IN LISTS EMBED_FILES)
+    get_filename_component(EMBED_NAME "${EMBED_FILE}" NAME)
+    string(MAKE_C_IDENTIFIER "${EMBED_NAME}" EMBED_ID)
+
+    file(READ "${SOURCE_DIR}/${EMBED_FILE}" EMBED_HEX HEX)
+    string(LENGTH "${EMBED_HEX}" EMBED_HEX_LENGTH)
+    math(EXPR EMBED_SIZE "${EMBED_HEX_LENGTH} / 2")
+
+    # 每16字节换行，末尾补0保证数组非空
+    string(REGEX REPLACE "([0-9a-f][0-9a-f])" "0x\\1," EMBED_BYTES "${EMBED_HEX}")
+    string(REGEX REPLACE "(${EMBED_LINE_PATTERN})" "\\1\n        " EMBED_BYTES "${EMBED_BYTES}")
+
+    string(APPEND CONTENT "\n    inline constexpr unsigned char k_${EMBED_ID}[] = {\n        ${EMBED_BYTES}0x00};\n")
+    string(APPEND CONTENT "    inline constexpr std::size_t k_${EMBED_ID}_size = ${EMBED_SIZE};\n")
+    string(APPEND TABLE "        {\"${EMBED_NAME}\", k_${EMBED_ID}, k_${EMBED_ID}_size},\n")
+endforeach ()
+
+string(APPEND CONTENT "\n    struct File {\n        std::string_view     name;\n")
+string(APPEND CONTENT "        unsigned char const* data;\n        std::size_t          size;\n    };\n\n")
+string(APPEND CONTENT "    inline constexpr File kFiles[] = {\n${TABLE}    };\n} // namespace Yume::embedded\n")
+
+file(WRITE "${OUTPUT}.tmp" "${CONTENT}")
+execute_process(COMMAND ${CMAKE_COMMAND} -E copy_if_different "${OUTPUT}.tmp" "${OUTPUT}")
+file(REMOVE "${OUTPUT}.tmp")
@@ -0,0 +1,65 @@
+//
+// 自适应轮询：按每个仓库观察到的提交间隔（指数平滑）决定下一次检查的时间
+// 活跃仓库频繁检查，长期无提交的仓库逐渐退避到上限；一旦发现新提交立即回到下限
+//
+
+#pragma once
+
+#include "head.hpp"
+#include "repository_registry.hpp"
+#include "state_journal.hpp"
+
+namespace Yume {
+
+    // 轮询间隔上下限（秒）
+    struct PollBounds {
+        int64_t minSeconds = 120;
+        int64_t maxSeconds = 3600;
+    };
+
+    class AdaptivePolling {
+    public:
+        static constexpr double kAlpha    = 0.3;  // 新间隔的权重
+        static constexpr double kFraction = 0.25; // 检查间隔取预计提交间隔的比例
+
+        // 仓库配置中的 minInterval / maxInterval（分钟）覆盖全局上下限
+        PollBounds static boundsFor(RepositoryEntry const* entry, PollBounds defaults) {
+            if (!entry) return defaults;
+            auto minutes = [&entry](char const* key, int64_t fallback) {
+                auto it = entry->extra.find(key);
+                return it != entry->extra.end() && it->is_number() ? it->get<int64_t>() * 60 : fallback;
+            };
+            PollBounds bounds;
+            bounds.minSeconds = std::max<int64_t>(60, minutes("minInterval", defaults.minSeconds));
+            bounds.maxSeconds = std::max(bounds.minSeconds, minutes("maxInterval", defaults.maxSeconds));
+            return bounds;
+        }
+
+        // 用新提交的时间更新平均间隔；早于已知最新提交的时间不参与计算
+        void static observe(RepoState& state, std::vector<int64_t> commitTimes) {
+            std::sort(commitTimes.begin(), commitTimes.end());
+            for (int64_t time : commitTimes) {
+                if (time <= state.lastCommit) continue;
+                if (state.lastCommit > 0) {
+                    auto gap      = static_cast<double>(time - state.lastCommit);
+                    state.meanGap = state.meanGap > 0 ? kAlpha * gap + (1 - kAlpha) * state.meanGap : gap;
+                }
+                state.lastCommit = time;
+            }
+        }
+
+        // 距下一次检查的秒数；没有历史数据时使用fallback
+        int64_t static interval(RepoState const& state, PollBounds bounds, int64_t now, bool changed,
+                                int64_t fallback) {
+            if (changed) return bounds.minSeconds;
+            double expected = state.meanGap;
+            // 沉默时间已超过平均间隔时按沉默时间估计，长期不活跃的仓库逐步退避
+            if (state.lastCommit > 0)
+                expected = std::max(expected, static_cast<double>(now - state.lastCommit));
+            if (expected <= 0) return std::clamp(fallback, bounds.minSeconds, bounds.maxSeconds);
+            auto seconds = static_cast<int64_t>(expected * kFraction);
+            return std::clamp(seconds, bounds.minSeconds, bounds.maxSeconds);
+        }
+    };
+
+} // namespace Yume
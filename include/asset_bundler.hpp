@@ -0,0 +1,319 @@
+//
+// 模板离线资源打包：把custom.css与index.html中引用的外部资源（Google Fonts、GitHub图标等）
+// 一次性下载到 Style/assets/ 并改写模板，使渲染不再依赖外部网络
+//
+
+#pragma once
+
+#include "head.hpp"
+#include "platform_utils.hpp"
+#include "theme.hpp"
+
+#include <zlib.h>
+
+namespace Yume {
+
+    class AssetBundler {
+    public:
+        explicit AssetBundler(std::string style_dir = "./Style"): m_style_dir(std::move(style_dir)) {}
+
+        // 打包所有外部资源，返回是否全部成功
+        bool bundle() {
+            std::error_code ec;
+            std::filesystem::create_directories(assetsDir() + "/fonts", ec);
+            if (ec) {
+                std::cerr << "无法创建资源目录: " << assetsDir() << " - " << ec.message() << std::endl;
+                return false;
+            }
+
+            bool ok = bundleStylesheet(PathUtils::joinPath(m_style_dir, "custom.css"));
+            ok      = bundleTemplate(PathUtils::joinPath(m_style_dir, "index.html")) && ok;
+
+            std::cout << "离线资源打包完成: 下载 " << m_downloaded << " 个文件，改写 " << m_rewritten
+                      << " 处引用" << (ok ? "" : "（部分资源失败）") << std::endl;
+            return ok;
+        }
+
+    private:
+        // 请求Google Fonts时使用现代浏览器UA，才能拿到带unicode-range分片的woff2
+        static constexpr char const* kBrowserUserAgent =
+            "Mozilla/5.0 (X11; Linux x86_64) AppleWebKit/537.36 (KHTML, like Gecko) "
+            "Chrome/124.0 Safari/537.36";
+
+        std::string m_style_dir;
+        size_t      m_downloaded = 0;
+        size_t      m_rewritten  = 0;
+
+        std::string assetsDir() const { return PathUtils::joinPath(m_style_dir, "assets"); }
+
+        bool static isRemote(std::string const& url) {
+            return url.rfind("https://", 0) == 0 || url.rfind("http://", 0) == 0
+                || url.rfind("//", 0) == 0;
+        }
+
+        std::string static normalizeUrl(std::string const& url) {
+            return url.rfind("//", 0) == 0 ? "https:" + url : url;
+        }
+
+        // 以URL的CRC32作前缀生成本地文件名，避免不同来源的同名文件冲突
+        std::string static localName(std::string const& url, std::string const& fallbackExt) {
+            std::string path = url.substr(0, url.find_first_of("?#"));
+            std::string base = path.substr(path.find_last_of('/') + 1);
+            if (base.empty() || base.find('.') == std::string::npos) base += fallbackExt;
+            for (char& c : base)
+                if (!std::isalnum(static_cast<unsigned char>(c)) && c != '.' && c != '-') c = '_';
+
+            auto const* bytes = reinterpret_cast<Bytef const*>(url.data());
+            uLong       crc   = crc32(0L, bytes, static_cast<uInt>(url.size()));
+
+            std::ostringstream oss;
+            oss << std::hex << std::setw(8) << std::setfill('0') << crc << "-" << base;
+            return oss.str();
+        }
+
+        // 样式目录中没有该文件时以内置主题为起点，打包结果写回样式目录作为覆盖文件
+        bool static readFile(std::string const& path, std::string& content) {
+            std::ifstream in(path, std::ios::binary);
+            if (!in.is_open()) {
+                std::string name = std::filesystem::path(path).filename().string();
+                content          = std::string(ThemeResources::embeddedFile(name));
+                return !content.empty();
+            }
+            std::stringstream buffer;
+            buffer << in.rdbuf();
+            content = buffer.str();
+            return true;
+        }
+
+        // 先写临时文件再重命名，避免中断时留下半个模板
+        bool static writeFileAtomic(std::string const& path, std::string const& content) {
+            std::string   tmpPath = path + ".tmp";
+            std::ofstream out(tmpPath, std::ios::binary | std::ios::trunc);
+            if (!out.is_open()) {
+                std::cerr << "无法写入文件: " << tmpPath << std::endl;
+                return false;
+            }
+            out << content;
+            out.close();
+            std::error_code ec;
+            std::filesystem::rename(tmpPath, path, ec);
+            if (ec) {
+                std::cerr << "无法替换文件: " << path << " - " << ec.message() << std::endl;
+                return false;
+            }
+            return true;
+        }
+
+        bool static download(std::string const& url, std::string& body,
+                             char const* userAgent = kBrowserUserAgent) {
+            CURL* curl = curl_easy_init();
+            if (!curl) return false;
+            body.clear();
+            curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
+            curl_easy_setopt(curl, CURLOPT_USERAGENT, userAgent);
+            curl_easy_setopt(curl, CURLOPT_FOLLOWLOCATION, 1L);
+            curl_easy_setopt(curl, CURLOPT_TIMEOUT, 30L);
+            curl_easy_setopt(curl, CURLOPT_ACCEPT_ENCODING, "");
+            curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, &AssetBundler::appendBody);
+            curl_easy_setopt(curl, CURLOPT_WRITEDATA, &body);
+
+            CURLcode res       = curl_easy_perform(curl);
+            long     http_code = 0;
+            curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &http_code);
+            curl_easy_cleanup(curl);
+
+            if (res != CURLE_OK) {
+                std::cerr << "下载失败: " << url << " - " << curl_easy_strerror(res) << std::endl;
+                return false;
+            }
+            if (http_code >= 400) {
+                std::cerr << "下载失败: " << url << " - HTTP " << http_code << std::endl;
+                return false;
+            }
+            return true;
+        }
+
+        size_t static appendBody(void* contents, size_t size, size_t nmemb, std::string* s) {
+            s->append(static_cast<char*>(contents), size * nmemb);
+            return size * nmemb;
+        }
+
+        bool static isFontFile(std::string const& name) {
+            std::string extension = std::filesystem::path(name).extension().string();
+            return extension == ".woff2" || extension == ".woff" || extension == ".ttf"
+                || extension == ".otf" || extension == ".eot";
+        }
+
+        // 解析 @import 之后的 url(...) 或 "..."，返回URL结束后的位置
+        size_t static parseImportUrl(std::string const& css, size_t pos, std::string& url) {
+            pos = css.find_first_not_of(" \t\r\n", pos);
+            if (pos == std::string::npos) return pos;
+
+            size_t end = std::string::npos;
+            if (css.compare(pos, 4, "url(") == 0) {
+                end = css.find(')', pos + 4);
+                if (end == std::string::npos) return end;
+                url = css.substr(pos + 4, end - pos - 4);
+                ++end;
+            } else if (css[pos] == '"' || css[pos] == '\'') {
+                end = css.find(css[pos], pos + 1);
+                if (end == std::string::npos) return end;
+                url = css.substr(pos + 1, end - pos - 1);
+                ++end;
+            } else {
+                return pos;
+            }
+            url.erase(0, url.find_first_not_of(" \t\"'"));
+            url.erase(url.find_last_not_of(" \t\"'") + 1);
+            return end;
+        }
+
+        // 下载到assets下的相对路径；已存在则跳过
+        bool fetchAsset(std::string const& url, std::string const& relativePath) {
+            std::string target = PathUtils::joinPath(assetsDir(), relativePath);
+            if (FileSystemUtils::fileExists(target)) return true;
+
+            std::string body;
+            if (!download(normalizeUrl(url), body)) return false;
+            if (!writeFileAtomic(target, body)) return false;
+            ++m_downloaded;
+            std::cout << "已下载: " << url << std::endl;
+            return true;
+        }
+
+        // 把样式表中所有url(...)指向的远程文件下载到fonts/，并改写为相对路径
+        bool localizeCssUrls(std::string& css, std::string const& prefix) {
+            bool   ok  = true;
+            size_t pos = 0;
+            while ((pos = css.find("url(", pos)) != std::string::npos) {
+                size_t start = pos + 4;
+                size_t end   = css.find(')', start);
+                if (end == std::string::npos) break;
+
+                std::string raw = css.substr(start, end - start);
+                std::string url = raw;
+                url.erase(0, url.find_first_not_of(" \t\"'"));
+                url.erase(url.find_last_not_of(" \t\"'") + 1);
+
+                if (!isRemote(url)) {
+                    pos = end;
+                    continue;
+                }
+
+                std::string name = localName(url, ".woff2");
+                if (isFontFile(name)) name = "fonts/" + name;
+                if (!fetchAsset(url, name)) {
+                    ok  = false;
+                    pos = end;
+                    continue;
+                }
+
+                std::string replacement = "'" + prefix + name + "'";
+                css.replace(start, end - start, replacement);
+                pos = start + replacement.size();
+                ++m_rewritten;
+            }
+            return ok;
+        }
+
+        // 处理custom.css中的 @import url('https://...')：下载样式表及其字体，改为导入本地副本
+        bool bundleStylesheet(std::string const& cssPath) {
+            std::string css;
+            if (!readFile(cssPath, css)) {
+                std::cerr << "无法读取样式文件: " << cssPath << std::endl;
+                return false;
+            }
+
+            bool   ok      = true;
+            bool   changed = false;
+            size_t pos     = 0;
+            while ((pos = css.find("@import", pos)) != std::string::npos) {
+                // URL本身可能包含';'（如 wght@400;700），因此先定位URL的结束位置再找语句结尾
+                std::string url;
+                size_t      urlEnd = parseImportUrl(css, pos + 7, url);
+                if (urlEnd == std::string::npos) break;
+                size_t lineEnd = css.find(';', urlEnd);
+                if (lineEnd == std::string::npos) break;
+                if (url.empty() || !isRemote(url)) {
+                    pos = lineEnd;
+                    continue;
+                }
+
+                std::string imported;
+                if (!download(normalizeUrl(url), imported)) {
+                    ok  = false;
+                    pos = lineEnd;
+                    continue;
+                }
+                ++m_downloaded;
+
+                // 字体文件位于assets/fonts/，导入的样式表位于assets/，因此前缀为空
+                ok = localizeCssUrls(imported, "") && ok;
+
+                std::string localCss = localName(url, ".css");
+                if (!writeFileAtomic(PathUtils::joinPath(assetsDir(), localCss), imported)) {
+                    ok  = false;
+                    pos = lineEnd;
+                    continue;
+                }
+
+                std::string replacement = "@import url('assets/" + localCss + "')";
+                css.replace(pos, lineEnd - pos, replacement);
+                pos     = pos + replacement.size();
+                changed = true;
+                ++m_rewritten;
+            }
+
+            // 样式表中直接引用的远程资源（如背景图）同样本地化
+            size_t before = m_rewritten;
+            ok            = localizeCssUrls(css, "assets/") && ok;
+            changed       = changed || m_rewritten != before;
+
+            if (changed && !writeFileAtomic(cssPath, css)) return false;
+            return ok;
+        }
+
+        // 处理index.html中静态的 src="https://..." / href="https://..."，模板变量不受影响
+        bool bundleTemplate(std::string const& htmlPath) {
+            std::string html;
+            if (!readFile(htmlPath, html)) {
+                std::cerr << "无法读取模板文件: " << htmlPath << std::endl;
+                return false;
+            }
+
+            bool ok      = true;
+            bool changed = false;
+            for (std::string attribute : {"src=\"", "href=\""}) {
+                size_t pos = 0;
+                while ((pos = html.find(attribute, pos)) != std::string::npos) {
+                    size_t start = pos + attribute.size();
+                    size_t end   = html.find('"', start);
+                    if (end == std::string::npos) break;
+
+                    std::string url = html.substr(start, end - start);
+                    if (!isRemote(url) || url.find("{{") != std::string::npos) {
+                        pos = end;
+                        continue;
+                    }
+
+                    std::string name = localName(url, "");
+                    if (!fetchAsset(url, name)) {
+                        ok  = false;
+                        pos = end;
+                        continue;
+                    }
+
+                    std::string replacement = "assets/" + name;
+                    html.replace(start, end - start, replacement);
+                    pos     = start + replacement.size();
+                    changed = true;
+                    ++m_rewritten;
+                }
+            }
+
+            if (changed && !writeFileAtomic(htmlPath, html)) return false;
+            return ok;
+        }
+    };
+
+} // namespace Yume
@@ -0,0 +1,210 @@
+//
+// 背景图片预缩放缓存：按卡片视口尺寸和设备像素比生成缩小、重新编码的版本
+// 缓存文件以源文件内容哈希命名，源文件变化后自动生成新版本
+//
+
+#pragma once
+
+#include <mutex>
+#include <set>
+#include <unordered_map>
+
+#include "head.hpp"
+#include "platform_utils.hpp"
+#include "theme.hpp"
+
+#include <zlib.h>
+
+namespace Yume {
+
+    // 预缩放参数，默认与screenshot.js的最小视口一致
+    struct BackgroundScaleOptions {
+        bool   enabled     = true;
+        int    width       = 1000;
+        int    height      = 800;
+        double deviceScale = 1.0;
+        int    quality     = 85;
+
+        bool operator==(BackgroundScaleOptions const&) const = default;
+    };
+
+    class BackgroundVariantCache {
+    public:
+        BackgroundVariantCache(std::string style_dir, ThemeResources& theme):
+            m_style_dir(std::move(style_dir)), m_theme(theme) {}
+
+        void setOptions(BackgroundScaleOptions const& options) {
+            std::lock_guard lock(m_mutex);
+            m_options = options;
+        }
+
+        BackgroundScaleOptions options() {
+            std::lock_guard lock(m_mutex);
+            return m_options;
+        }
+
+        // 缓存目录: <style>/backgrounds/.cache
+        std::string cacheDir() const { return PathUtils::joinPath(m_style_dir, "backgrounds/.cache"); }
+
+        // 返回源图片对应的缩放版本路径（相对样式目录），必要时先生成；失败返回空字符串
+        std::string variantFor(std::string const& sourcePath) {
+            std::vector<std::string> sources{sourcePath};
+            auto                     result = ensureVariants(sources);
+            auto                     it     = result.find(sourcePath);
+            return it != result.end() ? it->second : "";
+        }
+
+        // 批量确保缩放版本存在，只启动一次渲染进程；返回 源路径 -> 相对样式目录的缩放版本路径
+        std::map<std::string, std::string> ensureVariants(std::vector<std::string> const& sourcePaths) {
+            std::map<std::string, std::string> result;
+            BackgroundScaleOptions             opts = options();
+            if (!opts.enabled) return result;
+
+            nlohmann::json                                   jobs = nlohmann::json::array();
+            std::vector<std::pair<std::string, std::string>> pending;
+            for (auto const& source : sourcePaths) {
+                std::string hash = sourceHash(source);
+                if (hash.empty()) continue;
+
+                std::string fileName = variantName(hash, opts);
+                std::string variant  = PathUtils::joinPath(cacheDir(), fileName);
+                std::string relative = "backgrounds/.cache/" + fileName;
+                if (FileSystemUtils::fileExists(variant)) {
+                    result[source] = relative;
+                    continue;
+                }
+                if (hasFailed(fileName)) continue; // 本进程内已失败过，不再重复尝试
+
+                nlohmann::json job;
+                job["src"]     = std::filesystem::absolute(source).lexically_normal().generic_string();
+                job["out"]     = std::filesystem::absolute(variant).lexically_normal().generic_string();
+                job["width"]   = static_cast<int>(opts.width * opts.deviceScale);
+                job["height"]  = static_cast<int>(opts.height * opts.deviceScale);
+                job["quality"] = opts.quality;
+                jobs.push_back(std::move(job));
+                pending.emplace_back(source, relative);
+            }
+            if (pending.empty()) return result;
+
+            runScaler(jobs);
+
+            for (auto const& [source, relative] : pending) {
+                if (FileSystemUtils::fileExists(PathUtils::joinPath(m_style_dir, relative)))
+                    result[source] = relative;
+                else markFailed(std::filesystem::path(relative).filename().string());
+            }
+            return result;
+        }
+
+        // 删除不再对应任何源文件或参数已变化的缩放版本
+        size_t prune(std::vector<std::string> const& sourcePaths) {
+            std::set<std::string>  live;
+            BackgroundScaleOptions opts = options();
+            for (auto const& source : sourcePaths) {
+                std::string hash = sourceHash(source);
+                if (!hash.empty()) live.insert(variantName(hash, opts));
+            }
+
+            size_t          removed = 0;
+            std::error_code ec;
+            if (!std::filesystem::is_directory(cacheDir(), ec)) return 0;
+            for (auto const& entry : std::filesystem::directory_iterator(cacheDir(), ec)) {
+                if (!entry.is_regular_file(ec) || live.count(entry.path().filename().string())) continue;
+                if (std::filesystem::remove(entry.path(), ec)) ++removed;
+            }
+            return removed;
+        }
+
+        // 源文件内容的CRC32与长度；按(路径, 修改时间, 大小)记忆，未变化的文件不重复读取
+        std::string sourceHash(std::string const& sourcePath) {
+            std::error_code ec;
+            auto size = std::filesystem::file_size(sourcePath, ec);
+            if (ec) return "";
+            auto writeTime = std::filesystem::last_write_time(sourcePath, ec);
+            if (ec) return "";
+
+            {
+                std::lock_guard lock(m_mutex);
+                auto            it = m_hashes.find(sourcePath);
+                if (it != m_hashes.end() && it->second.size == size && it->second.writeTime == writeTime)
+                    return it->second.hash;
+            }
+
+            std::ifstream in(sourcePath, std::ios::binary);
+            if (!in.is_open()) return "";
+            uLong             crc = crc32(0L, Z_NULL, 0);
+            std::vector<char> buffer(1 << 16);
+            while (in) {
+                in.read(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+                auto count = in.gcount();
+                if (count <= 0) continue;
+                crc = crc32(crc, reinterpret_cast<Bytef const*>(buffer.data()), static_cast<uInt>(count));
+            }
+
+            std::ostringstream oss;
+            oss << std::hex << std::setw(8) << std::setfill('0') << crc << "-" << size;
+            std::string hash = oss.str();
+
+            std::lock_guard lock(m_mutex);
+            m_hashes[sourcePath] = {size, writeTime, hash};
+            return hash;
+        }
+
+    private:
+        struct HashEntry {
+            uintmax_t                       size = 0;
+            std::filesystem::file_time_type writeTime{};
+            std::string                     hash;
+        };
+
+        std::string                                m_style_dir;
+        ThemeResources&                            m_theme;
+        std::mutex                                 m_mutex;
+        BackgroundScaleOptions                     m_options;
+        std::unordered_map<std::string, HashEntry> m_hashes;
+        std::set<std::string>                      m_failed;
+
+        bool hasFailed(std::string const& variantName) {
+            std::lock_guard lock(m_mutex);
+            return m_failed.count(variantName) > 0;
+        }
+
+        void markFailed(std::string const& variantName) {
+            std::lock_guard lock(m_mutex);
+            m_failed.insert(variantName);
+        }
+
+        std::string static variantName(std::string const& hash, BackgroundScaleOptions const& opts) {
+            std::ostringstream oss;
+            oss << hash << "-" << opts.width << "x" << opts.height << "@"
+                << static_cast<int>(opts.deviceScale * 100) << "-q" << opts.quality << ".webp";
+            return oss.str();
+        }
+
+        // 调用prescale.js批量生成缩放版本
+        bool runScaler(nlohmann::json const& jobs) const {
+            std::string scriptPath = m_theme.scriptPath(ThemeResources::kPrescaler);
+            if (scriptPath.empty()) return false;
+
+            std::error_code ec;
+            std::filesystem::create_directories(cacheDir(), ec);
+            if (ec) {
+                std::cerr << "无法创建背景缓存目录: " << cacheDir() << " - " << ec.message() << std::endl;
+                return false;
+            }
+
+            nlohmann::json payload;
+            payload["jobs"] = jobs;
+
+            std::string command = CommandUtils::buildNodeCommand(scriptPath, {"-"});
+            std::cout << "正在预缩放 " << jobs.size() << " 张背景图片..." << std::endl;
+            int result = CommandUtils::executeCommandWithInput(command, payload.dump());
+            if (result != 0) {
+                std::cerr << "背景预缩放失败，返回代码: " << result << std::endl;
+                return false;
+            }
+            return true;
+        }
+    };
+
+} // namespace Yume
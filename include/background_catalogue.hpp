@@ -0,0 +1,301 @@
+//
+// 背景图片目录索引：只扫描一次，之后通过inotify（或目录修改时间）增量维护
+//
+
+#pragma once
+
+#include <algorithm>
+#include <mutex>
+
+#include "head.hpp"
+
+#ifdef YUMECARD_PLATFORM_LINUX
+    #include <poll.h>
+
+    #include <sys/inotify.h>
+#endif
+
+namespace Yume {
+
+    // 背景选择模式
+    enum class BackgroundSelectMode {
+        Random,   // 均匀随机
+        Weighted, // 按配置权重随机
+        PerRepo   // 每个仓库固定对应一张图片
+    };
+
+    class BackgroundCatalogue {
+    public:
+        explicit BackgroundCatalogue(std::string directory):
+            m_directory(std::move(directory)), m_rng(std::random_device{}()) {
+            rescan();
+            startWatcher();
+        }
+
+        ~BackgroundCatalogue() { stopWatcher(); }
+
+        BackgroundCatalogue(BackgroundCatalogue const&)            = delete;
+        BackgroundCatalogue& operator=(BackgroundCatalogue const&) = delete;
+
+        BackgroundSelectMode static parseMode(std::string const& mode) {
+            if (mode == "weighted") return BackgroundSelectMode::Weighted;
+            if (mode == "repo" || mode == "per-repo") return BackgroundSelectMode::PerRepo;
+            return BackgroundSelectMode::Random;
+        }
+
+        bool static isImageFile(std::string const& filename) {
+            std::string extension = std::filesystem::path(filename).extension().string();
+            std::transform(extension.begin(), extension.end(), extension.begin(),
+                           [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+            return extension == ".jpg" || extension == ".jpeg" || extension == ".png"
+                || extension == ".gif";
+        }
+
+        void setMode(BackgroundSelectMode mode) {
+            std::lock_guard lock(m_mutex);
+            m_mode = mode;
+        }
+
+        // 文件名 -> 权重，未列出的图片权重为1
+        void setWeights(std::map<std::string, double> weights) {
+            std::lock_guard lock(m_mutex);
+            if (weights == m_weights) return;
+            m_weights      = std::move(weights);
+            m_weightsDirty = true;
+        }
+
+        std::string const& directory() const { return m_directory; }
+
+        size_t size() {
+            std::lock_guard lock(m_mutex);
+            refreshIfChanged();
+            return m_images.size();
+        }
+
+        // 选择一张背景图片，返回完整路径；key用于PerRepo模式（通常为owner/repo）
+        std::string pick(std::string const& key = "") {
+            std::lock_guard lock(m_mutex);
+            refreshIfChanged();
+            if (m_images.empty()) return "";
+
+            size_t index = 0;
+            switch (m_mode) {
+                case BackgroundSelectMode::PerRepo:
+                    index = rendezvous(key);
+                    break;
+                case BackgroundSelectMode::Weighted:
+                    if (m_weightsDirty) rebuildDistribution();
+                    if (m_uniformFallback) {
+                        index = std::uniform_int_distribution<size_t>(0, m_images.size() - 1)(m_rng);
+                        break;
+                    }
+                    index = m_distribution(m_rng);
+                    break;
+                case BackgroundSelectMode::Random:
+                default:
+                    index = std::uniform_int_distribution<size_t>(0, m_images.size() - 1)(m_rng);
+                    break;
+            }
+            return (std::filesystem::path(m_directory) / m_images[index]).string();
+        }
+
+        // 当前索引中的所有图片（完整路径）
+        std::vector<std::string> images() {
+            std::lock_guard lock(m_mutex);
+            refreshIfChanged();
+            std::vector<std::string> result;
+            result.reserve(m_images.size());
+            for (auto const& name : m_images)
+                result.push_back((std::filesystem::path(m_directory) / name).string());
+            return result;
+        }
+
+        // 重新完整扫描目录
+        void rescan() {
+            std::lock_guard lock(m_mutex);
+            rescanLocked();
+        }
+
+    private:
+        std::string                     m_directory;
+        std::mutex                      m_mutex;
+        std::vector<std::string>        m_images; // 按文件名排序
+        std::mt19937                    m_rng;
+        BackgroundSelectMode            m_mode = BackgroundSelectMode::Random;
+        std::map<std::string, double>   m_weights;
+        std::discrete_distribution<int> m_distribution;
+        bool                            m_weightsDirty    = true;
+        bool                            m_uniformFallback = false; // 权重之和为0时改为均匀随机
+
+        std::filesystem::file_time_type       m_dirWriteTime{};
+        std::chrono::steady_clock::time_point m_lastCheck{};
+
+        std::thread       m_watcher;
+        std::atomic<bool> m_stop{false};
+#ifdef YUMECARD_PLATFORM_LINUX
+        int  m_inotifyFd = -1;
+        bool m_watching  = false; // 目录被删除或移走后监视失效，改为检查修改时间
+#endif
+
+        void rescanLocked() {
+            m_images.clear();
+            std::error_code ec;
+            if (!std::filesystem::is_directory(m_directory, ec)) {
+                std::cerr << "背景图片目录不存在: " << m_directory << std::endl;
+            } else {
+                for (auto const& entry : std::filesystem::directory_iterator(m_directory, ec)) {
+                    if (!entry.is_regular_file(ec)) continue;
+                    std::string name = entry.path().filename().string();
+                    if (isImageFile(name)) m_images.push_back(std::move(name));
+                }
+                std::sort(m_images.begin(), m_images.end());
+                m_dirWriteTime = std::filesystem::last_write_time(m_directory, ec);
+            }
+            m_lastCheck    = std::chrono::steady_clock::now();
+            m_weightsDirty = true;
+        }
+
+        // 没有inotify时（非Linux或初始化失败），最多每隔几秒检查一次目录修改时间
+        void refreshIfChanged() {
+#ifdef YUMECARD_PLATFORM_LINUX
+            if (m_watching) return;
+#endif
+            auto now = std::chrono::steady_clock::now();
+            if (now - m_lastCheck < std::chrono::seconds(5)) return;
+            m_lastCheck = now;
+            std::error_code ec;
+            auto            writeTime = std::filesystem::last_write_time(m_directory, ec);
+            if (!ec && writeTime != m_dirWriteTime) rescanLocked();
+        }
+
+        void addImageLocked(std::string const& name) {
+            if (!isImageFile(name)) return;
+            auto it = std::lower_bound(m_images.begin(), m_images.end(), name);
+            if (it != m_images.end() && *it == name) return;
+            m_images.insert(it, name);
+            m_weightsDirty = true;
+        }
+
+        void removeImageLocked(std::string const& name) {
+            auto it = std::lower_bound(m_images.begin(), m_images.end(), name);
+            if (it == m_images.end() || *it != name) return;
+            m_images.erase(it);
+            m_weightsDirty = true;
+        }
+
+        void rebuildDistribution() {
+            std::vector<double> weights;
+            weights.reserve(m_images.size());
+            double total = 0;
+            for (auto const& name : m_images) {
+                auto it = m_weights.find(name);
+                weights.push_back(it != m_weights.end() ? std::max(0.0, it->second) : 1.0);
+                total += weights.back();
+            }
+            // discrete_distribution要求权重之和大于0
+            m_uniformFallback = !(total > 0);
+            if (m_uniformFallback) std::cerr << "背景图片的权重都不大于0，改为均匀随机选择" << std::endl;
+            else m_distribution = std::discrete_distribution<int>(weights.begin(), weights.end());
+            m_weightsDirty = false;
+        }
+
+        uint64_t static fnv1a(std::string_view text, uint64_t hash = 1469598103934665603ULL) {
+            for (unsigned char c : text) {
+                hash ^= c;
+                hash *= 1099511628211ULL;
+            }
+            return hash;
+        }
+
+        // 最高随机权重（rendezvous）哈希：每个仓库选择与自己组合后得分最高的文件名，
+        // 得分只取决于仓库和文件名本身，增删图片时只有选中被删除图片或新图片得分更高的仓库会换背景
+        size_t rendezvous(std::string const& key) const {
+            uint64_t seed  = fnv1a(key);
+            size_t   best  = 0;
+            uint64_t score = 0;
+            for (size_t i = 0; i < m_images.size(); ++i) {
+                // FNV的低位扩散较差，再做一次splitmix64收尾
+                uint64_t h = fnv1a(m_images[i], seed);
+                h          = (h ^ (h >> 30)) * 0xbf58476d1ce4e5b9ULL;
+                h          = (h ^ (h >> 27)) * 0x94d049bb133111ebULL;
+                h ^= h >> 31;
+                if (i == 0 || h > score) {
+                    best  = i;
+                    score = h;
+                }
+            }
+            return best;
+        }
+
+        void startWatcher() {
+#ifdef YUMECARD_PLATFORM_LINUX
+            m_inotifyFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+            if (m_inotifyFd < 0) return;
+            int wd = inotify_add_watch(m_inotifyFd, m_directory.c_str(),
+                                       IN_CLOSE_WRITE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO
+                                           | IN_DELETE_SELF | IN_MOVE_SELF);
+            if (wd < 0) {
+                close(m_inotifyFd);
+                m_inotifyFd = -1;
+                return;
+            }
+            m_watching = true;
+            m_watcher  = std::thread([this]() { watchLoop(); });
+#endif
+        }
+
+        void stopWatcher() {
+            m_stop = true;
+            if (m_watcher.joinable()) m_watcher.join();
+#ifdef YUMECARD_PLATFORM_LINUX
+            if (m_inotifyFd >= 0) {
+                close(m_inotifyFd);
+                m_inotifyFd = -1;
+            }
+#endif
+        }
+
+#ifdef YUMECARD_PLATFORM_LINUX
+        void watchLoop() {
+            alignas(inotify_event) char buffer[4096];
+            while (!m_stop) {
+                {
+                    std::lock_guard lock(m_mutex);
+                    if (!m_watching) return;
+                }
+                pollfd pfd{m_inotifyFd, POLLIN, 0};
+                if (poll(&pfd, 1, 500) <= 0) continue;
+
+                ssize_t length = read(m_inotifyFd, buffer, sizeof(buffer));
+                if (length <= 0) continue;
+
+                std::lock_guard lock(m_mutex);
+                for (char* ptr = buffer; ptr < buffer + length;) {
+                    auto* event = reinterpret_cast<inotify_event*>(ptr);
+                    ptr += sizeof(inotify_event) + event->len;
+
+                    if (event->mask & (IN_DELETE_SELF | IN_MOVE_SELF | IN_IGNORED)) {
+                        // 目录被删除或移走，监视已失效（移走的目录仍被监视但已不是m_directory）：
+                        // 重扫一次，之后按修改时间检查，目录重新创建后也能发现其中的图片
+                        if (event->mask & IN_MOVE_SELF) inotify_rm_watch(m_inotifyFd, event->wd);
+                        m_watching = false;
+                        rescanLocked();
+                        return;
+                    }
+                    if (event->mask & IN_Q_OVERFLOW) {
+                        // 事件溢出：完整重扫一次
+                        rescanLocked();
+                        continue;
+                    }
+                    if (event->len == 0) continue;
+                    std::string name = event->name;
+                    // 只在写入完成或移入后加入索引，避免选中尚未写完的图片
+                    if (event->mask & (IN_CLOSE_WRITE | IN_MOVED_TO)) addImageLocked(name);
+                    else if (event->mask & (IN_DELETE | IN_MOVED_FROM)) removeImageLocked(name);
+                }
+            }
+        }
+#endif
+    };
+
+} // namespace Yume
@@ -0,0 +1,82 @@
+//
+// 有界阻塞队列：队列满时push等待，空时pop等待；close后pop取完剩余元素即返回std::nullopt
+//
+
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+
+#include "head.hpp"
+
+namespace Yume {
+
+    template <typename T>
+    class BoundedQueue {
+    public:
+        explicit BoundedQueue(size_t capacity): m_capacity(std::max<size_t>(1, capacity)) {}
+
+        // 队列已关闭时返回false
+        bool push(T item) {
+            std::unique_lock lock(m_mutex);
+            m_notFull.wait(lock, [this]() { return m_closed || m_items.size() < m_capacity; });
+            if (m_closed) return false;
+            m_items.push_back(std::move(item));
+            m_notEmpty.notify_one();
+            return true;
+        }
+
+        // 不等待，队列满或已关闭时返回false
+        bool tryPush(T item) {
+            std::lock_guard lock(m_mutex);
+            if (m_closed || m_items.size() >= m_capacity) return false;
+            m_items.push_back(std::move(item));
+            m_notEmpty.notify_one();
+            return true;
+        }
+
+        std::optional<T> pop() {
+            std::unique_lock lock(m_mutex);
+            m_notEmpty.wait(lock, [this]() { return m_closed || !m_items.empty(); });
+            if (m_items.empty()) return std::nullopt;
+            T item = std::move(m_items.front());
+            m_items.pop_front();
+            m_notFull.notify_one();
+            return item;
+        }
+
+        // 唤醒所有等待者；已入队的元素仍可取出
+        void close() {
+            std::lock_guard lock(m_mutex);
+            m_closed = true;
+            m_notEmpty.notify_all();
+            m_notFull.notify_all();
+        }
+
+        // 丢弃尚未取出的元素，返回丢弃的数量
+        size_t clear() {
+            std::lock_guard lock(m_mutex);
+            size_t          dropped = m_items.size();
+            m_items.clear();
+            m_notFull.notify_all();
+            return dropped;
+        }
+
+        size_t size() const {
+            std::lock_guard lock(m_mutex);
+            return m_items.size();
+        }
+
+        size_t capacity() const { return m_capacity; }
+
+    private:
+        size_t                  m_capacity;
+        mutable std::mutex      m_mutex;
+        std::condition_variable m_notEmpty;
+        std::condition_variable m_notFull;
+        std::deque<T>           m_items;
+        bool                    m_closed = false;
+    };
+
+} // namespace Yume
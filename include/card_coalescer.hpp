@@ -0,0 +1,109 @@
+//
+// 卡片合并：同一仓库在短时间内多次发现新提交时，先把提交合并到一张待发送的卡片中，
+// 仓库安静一段时间（quiet）或距第一次发现超过最长延迟（maxDelay）后才生成一次截图
+//
+
+#pragma once
+
+#include <mutex>
+
+#include "head.hpp"
+
+namespace Yume {
+
+    // 合并窗口（秒），quietSeconds为0时不合并
+    struct CoalesceWindow {
+        int64_t quietSeconds    = 0;
+        int64_t maxDelaySeconds = 0;
+
+        bool enabled() const { return quietSeconds > 0; }
+    };
+
+    template <typename Card>
+    class CardCoalescer {
+    public:
+        explicit CardCoalescer(CoalesceWindow window = {}): m_window(window) {}
+
+        // 配置变化时更新窗口；关闭合并后已等待的卡片在下一次takeDue时全部到期
+        void setWindow(CoalesceWindow window) {
+            std::lock_guard lock(m_mutex);
+            m_window = window;
+        }
+
+        CoalesceWindow window() const {
+            std::lock_guard lock(m_mutex);
+            return m_window;
+        }
+
+        // 加入一张卡片，已有同一仓库的待发送卡片时用merge(已有, 新的)合并并返回true
+        template <typename Merge>
+        bool add(std::string const& key, Card card, int64_t now, Merge&& merge) {
+            std::lock_guard lock(m_mutex);
+            auto            it = m_pending.find(key);
+            if (it == m_pending.end()) {
+                m_pending.emplace(key, Pending{std::move(card), now, now});
+                return false;
+            }
+            merge(it->second.card, std::move(card));
+            it->second.last = now;
+            return true;
+        }
+
+        // 取出一张已到期的卡片（最早加入的优先），没有时返回std::nullopt
+        std::optional<Card> takeDue(int64_t now) {
+            std::lock_guard lock(m_mutex);
+            auto            due = m_pending.end();
+            for (auto it = m_pending.begin(); it != m_pending.end(); ++it) {
+                if (!isDue(it->second, now)) continue;
+                if (due == m_pending.end() || it->second.first < due->second.first) due = it;
+            }
+            if (due == m_pending.end()) return std::nullopt;
+            Card card = std::move(due->second.card);
+            m_pending.erase(due);
+            return card;
+        }
+
+        // 不等窗口结束，取出指定仓库的待发送卡片
+        std::optional<Card> take(std::string const& key) {
+            std::lock_guard lock(m_mutex);
+            auto            it = m_pending.find(key);
+            if (it == m_pending.end()) return std::nullopt;
+            Card card = std::move(it->second.card);
+            m_pending.erase(it);
+            return card;
+        }
+
+        // 取出全部待发送的卡片（停止监控时使用）
+        std::vector<Card> takeAll() {
+            std::lock_guard   lock(m_mutex);
+            std::vector<Card> cards;
+            cards.reserve(m_pending.size());
+            for (auto& [key, pending] : m_pending) cards.push_back(std::move(pending.card));
+            m_pending.clear();
+            return cards;
+        }
+
+        size_t size() const {
+            std::lock_guard lock(m_mutex);
+            return m_pending.size();
+        }
+
+    private:
+        struct Pending {
+            Card    card;
+            int64_t first; // 第一次发现新提交的时间
+            int64_t last;  // 最近一次发现新提交的时间
+        };
+
+        mutable std::mutex             m_mutex;
+        CoalesceWindow                 m_window;
+        std::map<std::string, Pending> m_pending;
+
+        bool isDue(Pending const& pending, int64_t now) const {
+            if (!m_window.enabled()) return true;
+            return now - pending.last >= m_window.quietSeconds
+                || now - pending.first >= m_window.maxDelaySeconds;
+        }
+    };
+
+} // namespace Yume
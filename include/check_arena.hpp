@@ -0,0 +1,87 @@
+//
+// 检查内存区：解析一个仓库的抓取结果时，JSON节点、字符串和临时数组都从一块只增不减的内存区分配，
+// 检查结束时整体释放；监控长时间运行时不必为成千上万个小对象逐个调用malloc/free，也不会因此产生碎片
+//
+
+#pragma once
+
+#include <memory_resource>
+
+#include "head.hpp"
+
+namespace Yume {
+
+    // 在当前线程上生效的内存区，析构时恢复外层的内存区并释放全部内存
+    // 从内存区分配的对象必须在它析构之前销毁，不能离开创建它的作用域
+    class CheckArena {
+    public:
+        static constexpr size_t kBufferSize = 256 * 1024; // 每个线程复用的初始缓冲区，超出部分向系统申请
+
+        CheckArena() {
+            // 嵌套使用时只有最外层的内存区使用线程的缓冲区
+            if (t_bufferInUse) {
+                m_resource.emplace(upstream());
+            } else {
+                thread_local std::unique_ptr<std::byte[]> buffer;
+                if (!buffer) buffer = std::make_unique_for_overwrite<std::byte[]>(kBufferSize);
+                m_resource.emplace(buffer.get(), kBufferSize, upstream());
+                t_bufferInUse = m_ownsBuffer = true;
+            }
+            m_previous = std::exchange(t_current, &*m_resource);
+        }
+
+        ~CheckArena() {
+            t_current = m_previous;
+            m_resource.reset();
+            if (m_ownsBuffer) t_bufferInUse = false;
+        }
+
+        CheckArena(CheckArena const&)            = delete;
+        CheckArena& operator=(CheckArena const&) = delete;
+
+        // 当前线程的内存区，不在任何内存区的作用域内时使用new/delete
+        std::pmr::memory_resource static* resource() { return t_current ? t_current : upstream(); }
+
+    private:
+        std::optional<std::pmr::monotonic_buffer_resource> m_resource;
+        std::pmr::memory_resource*                         m_previous   = nullptr;
+        bool                                               m_ownsBuffer = false;
+
+        static thread_local inline std::pmr::memory_resource* t_current     = nullptr;
+        static thread_local inline bool                       t_bufferInUse = false;
+
+        std::pmr::memory_resource static* upstream() { return std::pmr::new_delete_resource(); }
+    };
+
+    // 默认构造时绑定当前线程的内存区；nlohmann::basic_json内部总是默认构造分配器，只能这样把内存区传进去
+    template <typename T>
+    struct ArenaAllocator {
+        using value_type = T;
+
+        std::pmr::memory_resource* resource;
+
+        ArenaAllocator() noexcept: resource(CheckArena::resource()) {}
+
+        template <typename U>
+        ArenaAllocator(ArenaAllocator<U> const& other) noexcept: resource(other.resource) {}
+
+        T* allocate(size_t n) { return static_cast<T*>(resource->allocate(n * sizeof(T), alignof(T))); }
+
+        void deallocate(T* p, size_t n) noexcept { resource->deallocate(p, n * sizeof(T), alignof(T)); }
+
+        // 拷贝出的容器使用拷贝时所在的内存区
+        ArenaAllocator select_on_container_copy_construction() const { return {}; }
+
+        template <typename U>
+        bool operator==(ArenaAllocator<U> const& other) const noexcept {
+            return resource == other.resource;
+        }
+    };
+
+    using ArenaString = std::basic_string<char, std::char_traits<char>, ArenaAllocator<char>>;
+
+    // 节点、数组与字符串都分配在当前内存区中的JSON，只用于在CheckArena作用域内解析并读取抓取结果
+    using ArenaJson = nlohmann::basic_json<std::map, std::vector, ArenaString, bool, std::int64_t,
+                                           std::uint64_t, double, ArenaAllocator>;
+
+} // namespace Yume
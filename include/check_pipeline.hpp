@@ -0,0 +1,143 @@
+//
+// 检查流水线：抓取（I/O）→ 解析 → 模板（CPU）→ 截图，各阶段由各自的线程执行并通过有界队列连接
+// I/O与截图阶段有独立的并发上限，CPU阶段运行在工作窃取线程池上；慢的截图不会占住抓取线程
+// 新的检查需先通过准入（同时在途的检查数有上限），因此阶段之间转交任务时队列不会满，也不会互相等待
+// 停止时先在期限内等待在途的检查与截图完成，超时则放弃尚未开始的任务
+//
+
+#pragma once
+
+#include <condition_variable>
+#include <mutex>
+
+#include "bounded_queue.hpp"
+#include "head.hpp"
+#include "work_stealing_pool.hpp"
+
+namespace Yume {
+
+    class CheckPipeline {
+    public:
+        using Task = std::function<void()>;
+
+        // renderBacklog为等待截图的卡片上限，截图长期跟不上时模板阶段才会等待
+        CheckPipeline(size_t ioThreads, size_t cpuThreads, size_t renderThreads,
+                      size_t renderBacklog = 32):
+            m_admissionLimit(std::max<size_t>(1, ioThreads) * 2),
+            m_ioQueue(m_admissionLimit),
+            m_cpu(std::make_unique<WorkStealingPool>(cpuThreads)),
+            m_renderQueue(renderBacklog) {
+            for (size_t i = 0; i < std::max<size_t>(1, ioThreads); ++i)
+                m_ioThreads.emplace_back([this]() { run(m_ioQueue); });
+            for (size_t i = 0; i < std::max<size_t>(1, renderThreads); ++i)
+                m_renderThreads.emplace_back([this]() { run(m_renderQueue); });
+        }
+
+        ~CheckPipeline() { shutdown(); }
+
+        CheckPipeline(CheckPipeline const&)            = delete;
+        CheckPipeline& operator=(CheckPipeline const&) = delete;
+
+        // 为一次新的检查申请名额，在途检查已满时返回false（调用方稍后再试）
+        bool tryAdmit() {
+            size_t current = m_inFlight.load();
+            while (current < m_admissionLimit)
+                if (m_inFlight.compare_exchange_weak(current, current + 1)) return true;
+            return false;
+        }
+
+        // 不受上限约束地占用名额，用于停止监控时提交剩余的合并卡片
+        void admit() { m_inFlight.fetch_add(1); }
+
+        // 一次检查离开抓取/解析/模板阶段（交给截图或无需截图）时归还名额
+        void finish() {
+            m_inFlight.fetch_sub(1);
+            notifyIdle();
+        }
+
+        void io(Task task) { m_ioQueue.push(std::move(task)); }
+
+        void cpu(Task task) { m_cpu->submit(std::move(task)); }
+
+        // 截图队列满时等待，限制待截图卡片占用的内存
+        void render(Task task) {
+            m_rendering.fetch_add(1);
+            bool queued = m_renderQueue.push([this, task = std::move(task)]() {
+                try {
+                    task();
+                } catch (...) {
+                    renderDone();
+                    throw;
+                }
+                renderDone();
+            });
+            if (!queued) renderDone();
+        }
+
+        size_t inFlight() const { return m_inFlight.load(); }
+
+        size_t renderBacklog() const { return m_renderQueue.size(); }
+
+        // 等待在途的检查与截图全部完成（调用方应已停止准入），超过deadline时返回false
+        bool drain(std::chrono::steady_clock::time_point deadline) {
+            std::unique_lock lock(m_idleMutex);
+            return m_idle.wait_until(lock, deadline, [this]() {
+                return m_inFlight.load() == 0 && m_rendering.load() == 0;
+            });
+        }
+
+        // 关闭各阶段并等待线程退出，关闭后提交的任务被丢弃；discard时已排队但未开始的I/O与截图任务
+        // 也被丢弃（正在执行的任务仍会完成），返回丢弃的数量
+        size_t shutdown(bool discard = false) {
+            if (m_stopped.exchange(true)) return 0;
+            size_t dropped = 0;
+            m_ioQueue.close();
+            if (discard) dropped += m_ioQueue.clear();
+            for (auto& thread : m_ioThreads) thread.join();
+            m_cpu.reset();
+            m_renderQueue.close();
+            if (discard) {
+                size_t renders = m_renderQueue.clear();
+                m_rendering.fetch_sub(renders);
+                dropped += renders;
+            }
+            for (auto& thread : m_renderThreads) thread.join();
+            return dropped;
+        }
+
+    private:
+        size_t                            m_admissionLimit;
+        std::atomic<size_t>               m_inFlight{0};
+        std::atomic<size_t>               m_rendering{0}; // 排队中与执行中的截图
+        std::atomic<bool>                 m_stopped{false};
+        std::mutex                        m_idleMutex;
+        std::condition_variable           m_idle;
+        BoundedQueue<Task>                m_ioQueue;
+        std::unique_ptr<WorkStealingPool> m_cpu;
+        BoundedQueue<Task>                m_renderQueue;
+        std::vector<std::thread>          m_ioThreads;
+        std::vector<std::thread>          m_renderThreads;
+
+        void renderDone() {
+            m_rendering.fetch_sub(1);
+            notifyIdle();
+        }
+
+        // 在锁内通知，避免drain检查条件后、开始等待前的通知丢失
+        void notifyIdle() {
+            std::lock_guard lock(m_idleMutex);
+            m_idle.notify_all();
+        }
+
+        void static run(BoundedQueue<Task>& queue) {
+            while (auto task = queue.pop()) {
+                try {
+                    (*task)();
+                } catch (std::exception const& e) {
+                    std::cerr << "后台任务异常: " << e.what() << std::endl;
+                }
+            }
+        }
+    };
+
+} // namespace Yume
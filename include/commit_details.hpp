@@ -0,0 +1,124 @@
+//
+// 按需获取的提交详情：由模板用到的变量决定是否需要，按SHA缓存
+// 列表接口已包含验证状态，合著者来自提交信息；只有增删行数需要逐个请求 /commits/{sha}
+//
+
+#pragma once
+
+#include <deque>
+#include <mutex>
+#include <unordered_map>
+
+#include "compiled_template.hpp"
+#include "head.hpp"
+#include "sha_key.hpp"
+
+namespace Yume {
+
+    struct CommitStats {
+        int additions    = 0;
+        int deletions    = 0;
+        int changedFiles = 0;
+    };
+
+    // 模板需要的额外数据
+    struct CommitDataNeeds {
+        bool stats        = false; // additions / deletions / changed_files 及其合计
+        bool verification = false; // verified
+        bool coAuthors    = false; // coauthors
+
+        CommitDataNeeds static from(CompiledTemplate const& compiled) {
+            CommitDataNeeds needs;
+            for (char const* name : {"additions", "deletions", "changed_files", "total_additions",
+                                     "total_deletions", "total_changed_files"})
+                needs.stats = needs.stats || compiled.uses(name);
+            needs.verification = compiled.uses("verified");
+            needs.coAuthors    = compiled.uses("coauthors");
+            return needs;
+        }
+    };
+
+    // SHA -> 增删统计，以二进制SHA为键；提交内容不可变，缓存无需失效，只按插入顺序淘汰最旧的条目
+    class CommitStatsCache {
+    public:
+        explicit CommitStatsCache(size_t capacity = 4096): m_capacity(capacity) {}
+
+        std::optional<CommitStats> find(std::string_view sha) {
+            auto key = ShaKey::fromHex(sha);
+            if (!key) return std::nullopt;
+            std::lock_guard lock(m_mutex);
+            auto            it = m_stats.find(*key);
+            if (it == m_stats.end()) return std::nullopt;
+            return it->second;
+        }
+
+        void put(std::string_view sha, CommitStats const& stats) {
+            auto key = ShaKey::fromHex(sha);
+            if (!key) return;
+            std::lock_guard lock(m_mutex);
+            if (!m_stats.insert_or_assign(*key, stats).second) return;
+            m_order.push_back(*key);
+            while (m_order.size() > m_capacity) {
+                m_stats.erase(m_order.front());
+                m_order.pop_front();
+            }
+        }
+
+        // 返回缓存中还没有的SHA
+        std::vector<std::string> missing(std::vector<std::string> const& shas) {
+            std::lock_guard          lock(m_mutex);
+            std::vector<std::string> result;
+            for (auto const& sha : shas) {
+                auto key = ShaKey::fromHex(sha);
+                if (!key || !m_stats.count(*key)) result.push_back(sha);
+            }
+            return result;
+        }
+
+        // 从 GET /repos/{owner}/{repo}/commits/{sha} 的响应中提取统计
+        CommitStats static parse(nlohmann::json const& commitJson) {
+            CommitStats stats;
+            if (commitJson.contains("stats") && commitJson["stats"].is_object()) {
+                stats.additions = commitJson["stats"].value("additions", 0);
+                stats.deletions = commitJson["stats"].value("deletions", 0);
+            }
+            if (commitJson.contains("files") && commitJson["files"].is_array())
+                stats.changedFiles = static_cast<int>(commitJson["files"].size());
+            return stats;
+        }
+
+    private:
+        size_t                                                m_capacity;
+        std::mutex                                            m_mutex;
+        std::unordered_map<ShaKey, CommitStats, ShaKey::Hash> m_stats;
+        std::deque<ShaKey>                                    m_order;
+    };
+
+    // 从提交信息中的 Co-authored-by: Name <email> 尾注提取合著者姓名
+    inline std::vector<std::string> parseCoAuthors(std::string_view message) {
+        std::vector<std::string> names;
+        constexpr std::string_view kTrailer = "co-authored-by:";
+        size_t                     pos      = 0;
+        while (pos < message.size()) {
+            size_t           end  = message.find('\n', pos);
+            std::string_view line = message.substr(pos, end == std::string_view::npos ? end : end - pos);
+            pos                   = end == std::string_view::npos ? message.size() : end + 1;
+
+            size_t first = line.find_first_not_of(" \t");
+            if (first == std::string_view::npos || line.size() - first < kTrailer.size()) continue;
+            bool match = true;
+            for (size_t i = 0; i < kTrailer.size() && match; ++i)
+                match = std::tolower(static_cast<unsigned char>(line[first + i])) == kTrailer[i];
+            if (!match) continue;
+
+            std::string_view value = line.substr(first + kTrailer.size());
+            value                  = value.substr(0, value.find('<'));
+            size_t nameStart       = value.find_first_not_of(" \t");
+            size_t nameEnd         = value.find_last_not_of(" \t\r");
+            if (nameStart == std::string_view::npos) continue;
+            names.emplace_back(value.substr(nameStart, nameEnd - nameStart + 1));
+        }
+        return names;
+    }
+
+} // namespace Yume
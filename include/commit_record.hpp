@@ -0,0 +1,163 @@
+//
+// 提交记录：一次抓取得到的提交按API返回的顺序（最新在前）连续存放，记录只保存视图：
+// 作者、仓库名、头像链接在提交之间大量重复，驻留到全局的字符串表；其余字段拷贝到该批次的一块缓冲区中
+//
+
+#pragma once
+
+#include <cstring>
+#include <memory>
+#include <span>
+
+#include "head.hpp"
+#include "string_interner.hpp"
+
+namespace Yume {
+
+    // author、repo、avatarUrl是驻留的视图，内容相同时data()也相同，可以直接比较指针
+    struct CommitRecord {
+        std::string_view sha;
+        std::string_view date;
+        std::string_view author; // 作者登录名
+        std::string_view repo;   // 从链接中提取的 owner/repo
+        std::string_view url;
+        std::string_view message;
+        std::string_view avatarUrl;
+        bool             verified = false;
+    };
+
+    class CommitBatch {
+    public:
+        CommitBatch() = default;
+
+        // 拷贝各记录的字段文本；传入的视图只需在构造期间有效
+        explicit CommitBatch(std::span<CommitRecord const> records) { assign(records); }
+
+        CommitBatch(CommitBatch const& other) { assign(other.m_records); }
+
+        CommitBatch& operator=(CommitBatch const& other) {
+            if (this != &other) assign(other.m_records);
+            return *this;
+        }
+
+        // 移动时缓冲区地址不变，视图仍然有效
+        CommitBatch(CommitBatch&&) noexcept            = default;
+        CommitBatch& operator=(CommitBatch&&) noexcept = default;
+
+        size_t size() const { return m_records.size(); }
+
+        bool empty() const { return m_records.empty(); }
+
+        auto begin() const { return m_records.begin(); }
+
+        auto end() const { return m_records.end(); }
+
+        CommitRecord const& operator[](size_t index) const { return m_records[index]; }
+
+        CommitRecord const* find(std::string_view sha) const {
+            auto it = std::find_if(m_records.begin(), m_records.end(),
+                                   [sha](CommitRecord const& record) { return record.sha == sha; });
+            return it != m_records.end() ? &*it : nullptr;
+        }
+
+        // 只保留最前面的count个提交，缓冲区不变
+        void truncate(size_t count) {
+            if (count < m_records.size()) m_records.resize(count);
+        }
+
+        // 只保留keep返回true的提交，顺序与缓冲区不变
+        template <typename Keep>
+        void retain(Keep&& keep) {
+            std::erase_if(m_records, [&keep](CommitRecord const& record) { return !keep(record); });
+        }
+
+        // 在后面追加另一批中尚未出现的提交
+        void append(CommitBatch const& other) {
+            std::vector<CommitRecord> records = m_records;
+            for (auto const& record : other)
+                if (!find(record.sha)) records.push_back(record);
+            assign(records);
+        }
+
+        // 控制套接字上传递的格式
+        nlohmann::json toJson() const {
+            nlohmann::json array = nlohmann::json::array();
+            for (auto const& record : m_records) {
+                array.push_back({
+                    {     "sha",       record.sha},
+                    {    "date",      record.date},
+                    {  "author",    record.author},
+                    {    "repo",      record.repo},
+                    {     "url",       record.url},
+                    { "message",   record.message},
+                    {  "avatar", record.avatarUrl},
+                    {"verified",  record.verified}
+                });
+            }
+            return array;
+        }
+
+        CommitBatch static fromJson(nlohmann::json const& array) {
+            std::vector<CommitRecord> records;
+            if (!array.is_array()) return CommitBatch(records);
+            records.reserve(array.size());
+            for (auto const& item : array) {
+                if (!item.is_object()) continue;
+                CommitRecord record;
+                record.sha       = text(item, "sha");
+                record.date      = text(item, "date");
+                record.author    = text(item, "author");
+                record.repo      = text(item, "repo");
+                record.url       = text(item, "url");
+                record.message   = text(item, "message");
+                record.avatarUrl = text(item, "avatar");
+                record.verified  = item.value("verified", false);
+                records.push_back(record);
+            }
+            return CommitBatch(records);
+        }
+
+        // JSON对象中字符串字段的视图，不拷贝；字段不存在或不是字符串时返回fallback
+        // 也用于分配在检查内存区中的ArenaJson
+        template <typename Json>
+        std::string_view static text(Json const& object, char const* key,
+                                     std::string_view fallback = {}) {
+            auto it = object.find(key);
+            if (it == object.end() || !it->is_string()) return fallback;
+            return it->template get_ref<typename Json::string_t const&>();
+        }
+
+    private:
+        std::unique_ptr<char[]>   m_text;
+        std::vector<CommitRecord> m_records;
+
+        // 先驻留重复字段并算出其余字段的总长度，一次分配后依次拷贝；records可以指向本批次原来的缓冲区
+        void assign(std::span<CommitRecord const> records) {
+            std::vector<CommitRecord>      copied(records.begin(), records.end());
+            std::vector<std::string_view*> owned; // 需要拷贝到缓冲区的字段
+            owned.reserve(copied.size() * 4);
+            size_t total = 0;
+            for (auto& record : copied) {
+                for (std::string_view* field : {&record.author, &record.repo, &record.avatarUrl}) {
+                    // 驻留表已满或文本过长时仍拷贝到本批次
+                    if (auto pinned = StringInterner::global().intern(*field)) *field = *pinned;
+                    else owned.push_back(field);
+                }
+                for (std::string_view* field : {&record.sha, &record.date, &record.url, &record.message})
+                    owned.push_back(field);
+            }
+            for (std::string_view const* field : owned) total += field->size();
+
+            auto  text   = std::make_unique_for_overwrite<char[]>(total);
+            char* cursor = text.get();
+            for (std::string_view* field : owned) {
+                if (!field->empty()) std::memcpy(cursor, field->data(), field->size());
+                *field = std::string_view(cursor, field->size());
+                cursor += field->size();
+            }
+            m_text    = std::move(text);
+            m_records = std::move(copied);
+        }
+    };
+
+} // namespace Yume
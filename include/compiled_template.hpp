@@ -0,0 +1,138 @@
+//
+// 预编译模板：加载时解析为文本、变量和 {{#each name}}...{{/each}} 区块，渲染时只做顺序拼接
+// 同时记录模板用到的全部变量，数据层据此决定需要额外获取哪些数据
+//
+
+#pragma once
+
+#include <set>
+
+#include "head.hpp"
+
+namespace Yume {
+
+    class CompiledTemplate {
+    public:
+        using Variables = std::map<std::string, std::string>;
+        using Sections  = std::map<std::string, std::vector<Variables>>;
+
+        CompiledTemplate() = default;
+
+        explicit CompiledTemplate(std::string_view source): m_sourceSize(source.size()) {
+            std::vector<Segment*> open; // 尚未闭合的区块
+            auto current = [&]() -> std::vector<Segment>& {
+                return open.empty() ? m_segments : open.back()->children;
+            };
+
+            size_t pos = 0;
+            while (pos < source.size()) {
+                size_t start = source.find("{{", pos);
+                size_t end   = start == std::string_view::npos ? start : source.find("}}", start + 2);
+                if (end == std::string_view::npos) {
+                    appendText(current(), source.substr(pos));
+                    break;
+                }
+                appendText(current(), source.substr(pos, start - pos));
+                pos = end + 2;
+
+                std::string_view tag = trim(source.substr(start + 2, end - start - 2));
+                if (tag.rfind("#each ", 0) == 0) {
+                    std::string name(trim(tag.substr(6)));
+                    m_sections.insert(name);
+                    current().push_back({Segment::Section, name, {}});
+                    open.push_back(&current().back());
+                } else if (tag == "/each" && !open.empty()) {
+                    open.pop_back();
+                } else if (isIdentifier(tag)) {
+                    m_variables.emplace(tag);
+                    current().push_back({Segment::Variable, std::string(tag), {}});
+                } else {
+                    // 不是模板标签（如内联脚本中的"{{"），原样保留
+                    appendText(current(), source.substr(start, end + 2 - start));
+                }
+            }
+            if (!open.empty())
+                std::cerr << "模板中的 {{#each}} 区块没有闭合，已在文件末尾自动结束" << std::endl;
+        }
+
+        // 模板中（含区块内）出现过的变量
+        std::set<std::string> const& variables() const { return m_variables; }
+
+        bool uses(std::string const& name) const { return m_variables.count(name) > 0; }
+
+        bool hasSection(std::string const& name) const { return m_sections.count(name) > 0; }
+
+        // 区块内的变量先在当前条目中查找，再查找全局变量；未提供的变量原样保留
+        std::string render(Variables const& variables, Sections const& sections = {}) const {
+            std::string out;
+            out.reserve(m_sourceSize * 2);
+            renderInto(out, m_segments, variables, nullptr, sections);
+            return out;
+        }
+
+    private:
+        struct Segment {
+            enum Kind { Text, Variable, Section };
+            Kind                 kind;
+            std::string          text; // 文本内容，或变量/区块名
+            std::vector<Segment> children;
+        };
+
+        std::vector<Segment>  m_segments;
+        std::set<std::string> m_variables;
+        std::set<std::string> m_sections;
+        size_t                m_sourceSize = 0;
+
+        void static appendText(std::vector<Segment>& segments, std::string_view text) {
+            if (text.empty()) return;
+            if (!segments.empty() && segments.back().kind == Segment::Text) segments.back().text += text;
+            else segments.push_back({Segment::Text, std::string(text), {}});
+        }
+
+        std::string_view static trim(std::string_view text) {
+            size_t first = text.find_first_not_of(" \t\r\n");
+            if (first == std::string_view::npos) return {};
+            size_t last = text.find_last_not_of(" \t\r\n");
+            return text.substr(first, last - first + 1);
+        }
+
+        bool static isIdentifier(std::string_view text) {
+            if (text.empty()) return false;
+            for (char c : text)
+                if (!std::isalnum(static_cast<unsigned char>(c)) && c != '_' && c != '.' && c != '-')
+                    return false;
+            return true;
+        }
+
+        void static renderInto(std::string& out, std::vector<Segment> const& segments,
+                               Variables const& variables, Variables const* item,
+                               Sections const& sections) {
+            for (auto const& segment : segments) {
+                switch (segment.kind) {
+                    case Segment::Text: out += segment.text; break;
+                    case Segment::Variable: {
+                        if (item) {
+                            auto it = item->find(segment.text);
+                            if (it != item->end()) {
+                                out += it->second;
+                                break;
+                            }
+                        }
+                        auto it = variables.find(segment.text);
+                        if (it != variables.end()) out += it->second;
+                        else out += "{{" + segment.text + "}}";
+                        break;
+                    }
+                    case Segment::Section: {
+                        auto it = sections.find(segment.text);
+                        if (it == sections.end()) break;
+                        for (auto const& row : it->second)
+                            renderInto(out, segment.children, variables, &row, sections);
+                        break;
+                    }
+                }
+            }
+        }
+    };
+
+} // namespace Yume
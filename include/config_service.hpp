@@ -0,0 +1,160 @@
+//
+// 配置热加载：监视配置文件所在目录（inotify，其他平台轮询修改时间），只在文件变化时解析
+// 解析结果作为不可变的ReadConfig快照，通过原子指针交换发布；读取方持有快照期间看到的配置始终一致
+//
+
+#pragma once
+
+#include <mutex>
+
+#include "head.hpp"
+#include "read_config.hpp"
+
+#ifdef YUMECARD_PLATFORM_LINUX
+    #include <poll.h>
+
+    #include <sys/inotify.h>
+#endif
+
+namespace Yume {
+
+    class ConfigService {
+    public:
+        using Snapshot = std::shared_ptr<ReadConfig const>;
+
+        explicit ConfigService(std::string config_path): m_config_path(std::move(config_path)) {
+            if (!reload()) {
+                auto empty = std::make_shared<ReadConfig const>(m_config_path, nlohmann::json::object());
+                m_current.store(std::move(empty));
+            }
+            startWatcher();
+        }
+
+        ~ConfigService() { stopWatcher(); }
+
+        ConfigService(ConfigService const&)            = delete;
+        ConfigService& operator=(ConfigService const&) = delete;
+
+        // 当前配置快照，无锁读取
+        Snapshot snapshot() const { return m_current.load(std::memory_order_acquire); }
+
+        // 每发布一次新快照加一
+        uint64_t version() const { return m_version.load(std::memory_order_acquire); }
+
+        std::string const& path() const { return m_config_path; }
+
+        // 重新解析并发布；文件不存在或内容不是合法JSON时保留上一个快照（如编辑器写到一半）
+        bool reload() {
+            std::lock_guard lock(m_reloadMutex);
+            std::ifstream   in(m_config_path);
+            if (!in.is_open()) {
+                std::cerr << "无法打开配置文件: " << m_config_path << std::endl;
+                return false;
+            }
+            nlohmann::json config;
+            try {
+                config = nlohmann::json::parse(in);
+            } catch (nlohmann::json::parse_error const& e) {
+                std::cerr << "配置文件解析失败，继续使用上一次的配置: " << e.what() << std::endl;
+                return false;
+            }
+
+            m_current.store(std::make_shared<ReadConfig const>(m_config_path, std::move(config)),
+                            std::memory_order_release);
+            m_version.fetch_add(1, std::memory_order_acq_rel);
+            std::error_code ec;
+            m_writeTime = std::filesystem::last_write_time(m_config_path, ec);
+            return true;
+        }
+
+    private:
+        std::string                                    m_config_path;
+        std::atomic<std::shared_ptr<ReadConfig const>> m_current;
+        std::atomic<uint64_t>                          m_version{0};
+        std::mutex                                     m_reloadMutex;
+        std::filesystem::file_time_type                m_writeTime{};
+
+        std::thread       m_watcher;
+        std::atomic<bool> m_stop{false};
+#ifdef YUMECARD_PLATFORM_LINUX
+        int m_inotifyFd = -1;
+#endif
+
+        std::string directory() const {
+            std::filesystem::path parent = std::filesystem::path(m_config_path).parent_path();
+            return parent.empty() ? "." : parent.string();
+        }
+
+        std::string fileName() const { return std::filesystem::path(m_config_path).filename().string(); }
+
+        void startWatcher() {
+#ifdef YUMECARD_PLATFORM_LINUX
+            m_inotifyFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+            if (m_inotifyFd >= 0) {
+                // 监视目录而不是文件：原子替换（写临时文件再重命名）会换掉文件本身
+                int wd = inotify_add_watch(m_inotifyFd, directory().c_str(),
+                                           IN_CLOSE_WRITE | IN_MOVED_TO | IN_DELETE_SELF | IN_MOVE_SELF);
+                if (wd >= 0) {
+                    m_watcher = std::thread([this]() { watchLoop(); });
+                    return;
+                }
+                close(m_inotifyFd);
+                m_inotifyFd = -1;
+            }
+#endif
+            m_watcher = std::thread([this]() { pollLoop(); });
+        }
+
+        void stopWatcher() {
+            m_stop = true;
+            if (m_watcher.joinable()) m_watcher.join();
+#ifdef YUMECARD_PLATFORM_LINUX
+            if (m_inotifyFd >= 0) {
+                close(m_inotifyFd);
+                m_inotifyFd = -1;
+            }
+#endif
+        }
+
+        // 没有inotify时每隔两秒比较一次修改时间
+        void pollLoop() {
+            while (!m_stop) {
+                for (int i = 0; i < 20 && !m_stop; ++i)
+                    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+                std::error_code ec;
+                auto            writeTime = std::filesystem::last_write_time(m_config_path, ec);
+                if (ec) continue;
+                bool changed;
+                {
+                    std::lock_guard lock(m_reloadMutex);
+                    changed = writeTime != m_writeTime;
+                }
+                if (changed && reload()) std::cout << "配置文件已更新，已重新加载" << std::endl;
+            }
+        }
+
+#ifdef YUMECARD_PLATFORM_LINUX
+        void watchLoop() {
+            alignas(inotify_event) char buffer[4096];
+            std::string                 name = fileName();
+            while (!m_stop) {
+                pollfd pfd{m_inotifyFd, POLLIN, 0};
+                if (poll(&pfd, 1, 500) <= 0) continue;
+
+                ssize_t length = read(m_inotifyFd, buffer, sizeof(buffer));
+                if (length <= 0) continue;
+
+                bool changed = false;
+                for (char* ptr = buffer; ptr < buffer + length;) {
+                    auto* event = reinterpret_cast<inotify_event*>(ptr);
+                    ptr += sizeof(inotify_event) + event->len;
+                    if (event->len > 0 && name == event->name) changed = true;
+                }
+                // 同一批事件只解析一次
+                if (changed && reload()) std::cout << "配置文件已更新，已重新加载" << std::endl;
+            }
+        }
+#endif
+    };
+
+} // namespace Yume
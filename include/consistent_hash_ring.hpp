@@ -0,0 +1,66 @@
+//
+// 一致性哈希环：每个成员在环上放置若干虚拟节点，键归属于顺时针方向遇到的第一个节点
+// 增减一个成员时只有约 1/N 的键改变归属，其余键仍由原来的成员处理
+//
+
+#pragma once
+
+#include "head.hpp"
+
+namespace Yume {
+
+    class ConsistentHashRing {
+    public:
+        static constexpr int kVirtualNodes = 160;
+
+        ConsistentHashRing() = default;
+
+        explicit ConsistentHashRing(std::vector<std::string> members, int virtualNodes = kVirtualNodes):
+            m_members(std::move(members)) {
+            std::sort(m_members.begin(), m_members.end());
+            m_members.erase(std::unique(m_members.begin(), m_members.end()), m_members.end());
+            m_points.reserve(m_members.size() * static_cast<size_t>(virtualNodes));
+            for (size_t i = 0; i < m_members.size(); ++i)
+                for (int node = 0; node < virtualNodes; ++node)
+                    m_points.emplace_back(hash(m_members[i] + "#" + std::to_string(node)), i);
+            std::sort(m_points.begin(), m_points.end());
+        }
+
+        bool empty() const { return m_members.empty(); }
+
+        // 按名称排序的成员
+        std::vector<std::string> const& members() const { return m_members; }
+
+        // 键所属的成员，环为空时返回空字符串
+        std::string const& owner(std::string_view key) const {
+            static std::string const none;
+            if (m_points.empty()) return none;
+            auto point = std::make_pair(hash(key), size_t{0});
+            auto it    = std::lower_bound(m_points.begin(), m_points.end(), point);
+            if (it == m_points.end()) it = m_points.begin();
+            return m_members[it->second];
+        }
+
+        bool operator==(ConsistentHashRing const& other) const { return m_members == other.m_members; }
+
+        // FNV-1a 后做一次雪崩混合，相近的虚拟节点名也能均匀分布在环上
+        uint64_t static hash(std::string_view text) {
+            uint64_t hash = 14695981039346656037ULL;
+            for (unsigned char c : text) {
+                hash ^= c;
+                hash *= 1099511628211ULL;
+            }
+            hash ^= hash >> 33;
+            hash *= 0xff51afd7ed558ccdULL;
+            hash ^= hash >> 33;
+            hash *= 0xc4ceb9fe1a85ec53ULL;
+            hash ^= hash >> 33;
+            return hash;
+        }
+
+    private:
+        std::vector<std::string>                 m_members;
+        std::vector<std::pair<uint64_t, size_t>> m_points; // (环上位置, 成员下标)
+    };
+
+} // namespace Yume
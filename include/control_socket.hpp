@@ -0,0 +1,290 @@
+//
+// 控制套接字：monitor运行时在配置目录下监听一个Unix域套接字，check、add、list、status等命令
+// 通过它交给正在运行的监控进程处理，复用其连接、缓存和检查队列，也不会与之争用状态文件
+// 每个连接发送一行JSON请求并收到一行JSON响应；Windows上不提供，命令总是在本地执行
+//
+
+#pragma once
+
+#include <cerrno>
+#include <cstring>
+#include <functional>
+#include <list>
+#include <mutex>
+
+#include "head.hpp"
+
+#ifndef YUMECARD_PLATFORM_WINDOWS
+    #include <poll.h>
+    #include <sys/socket.h>
+    #include <sys/un.h>
+#endif
+
+namespace Yume {
+
+    class ControlClient {
+    public:
+        static constexpr size_t kMaxRequest  = 64 * 1024;
+        static constexpr size_t kMaxResponse = 64 * 1024 * 1024; // list的响应包含全部仓库
+
+        // 配置文件所在目录下的 control.sock；分片模式下每个工作进程使用 control-<ID>.sock
+        std::string static pathFor(std::string const& configPath, std::string const& workerId = "") {
+            std::string name = workerId.empty() ? "control.sock" : "control-" + workerId + ".sock";
+            return (std::filesystem::path(configPath).parent_path() / name).string();
+        }
+
+        // 未指定工作进程时可能在监听的全部套接字：control.sock 以及分片模式下各工作进程的 control-<ID>.sock
+        std::vector<std::string> static pathsFor(std::string const& configPath) {
+            std::vector<std::string> paths{pathFor(configPath)};
+            std::vector<std::string> workers;
+            std::filesystem::path    directory = std::filesystem::path(configPath).parent_path();
+            std::error_code          ec;
+            for (auto const& file : std::filesystem::directory_iterator(directory, ec)) {
+                std::string name = file.path().filename().string();
+                if (name.starts_with("control-") && name.ends_with(".sock"))
+                    workers.push_back(file.path().string());
+            }
+            std::sort(workers.begin(), workers.end());
+            paths.insert(paths.end(), workers.begin(), workers.end());
+            return paths;
+        }
+
+        // 发送一个请求并等待响应；没有监控进程在监听时返回std::nullopt，调用方改为在本地执行
+        std::optional<nlohmann::json> static request(std::string const& path,
+                                                     nlohmann::json const& request,
+                                                     std::chrono::seconds  timeout) {
+#ifdef YUMECARD_PLATFORM_WINDOWS
+            return std::nullopt;
+#else
+            int fd = connectTo(path);
+            if (fd < 0) return std::nullopt;
+            setTimeout(fd, timeout);
+            std::string line;
+            bool        ok = writeAll(fd, request.dump() + "\n") && readLine(fd, line, kMaxResponse);
+            ::close(fd);
+            try {
+                if (ok) return nlohmann::json::parse(line);
+            } catch (nlohmann::json::exception const&) {
+            }
+            std::string message = "监控进程没有在 " + std::to_string(timeout.count()) + " 秒内给出有效响应";
+            return nlohmann::json{
+                {   "ok",   false},
+                {"error", message}
+            };
+#endif
+        }
+
+#ifndef YUMECARD_PLATFORM_WINDOWS
+        int static connectTo(std::string const& path) {
+            sockaddr_un address{};
+            if (path.size() >= sizeof(address.sun_path)) return -1;
+            int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+            if (fd < 0) return -1;
+            address.sun_family = AF_UNIX;
+            std::memcpy(address.sun_path, path.c_str(), path.size() + 1);
+            if (connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0) {
+                ::close(fd);
+                return -1;
+            }
+            return fd;
+        }
+
+        void static setTimeout(int fd, std::chrono::seconds timeout) {
+            timeval tv{};
+            tv.tv_sec = static_cast<time_t>(timeout.count());
+            setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+            setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+        }
+
+        bool static writeAll(int fd, std::string const& data) {
+            size_t written = 0;
+            while (written < data.size()) {
+                ssize_t n = send(fd, data.data() + written, data.size() - written, MSG_NOSIGNAL);
+                if (n <= 0) return false;
+                written += static_cast<size_t>(n);
+            }
+            return true;
+        }
+
+        // 读到换行为止，超过limit视为失败
+        bool static readLine(int fd, std::string& line, size_t limit) {
+            char buffer[4096];
+            while (line.size() < limit) {
+                ssize_t n = recv(fd, buffer, sizeof(buffer), 0);
+                if (n <= 0) return false;
+                line.append(buffer, static_cast<size_t>(n));
+                size_t end = line.find('\n');
+                if (end != std::string::npos) {
+                    line.resize(end);
+                    return true;
+                }
+            }
+            return false;
+        }
+#endif
+    };
+
+    class ControlServer {
+    public:
+        using Handler = std::function<nlohmann::json(nlohmann::json const&)>;
+
+        static constexpr size_t kMaxConnections = 8;
+
+        ControlServer(std::string path, Handler handler):
+            m_path(std::move(path)), m_handler(std::move(handler)) {}
+
+        ~ControlServer() { stop(); }
+
+        ControlServer(ControlServer const&)            = delete;
+        ControlServer& operator=(ControlServer const&) = delete;
+
+        // 已有监控进程在监听同一路径时失败；残留的套接字文件会被替换
+        bool start() {
+#ifdef YUMECARD_PLATFORM_WINDOWS
+            return false;
+#else
+            sockaddr_un address{};
+            if (m_path.size() >= sizeof(address.sun_path)) {
+                std::cerr << "控制套接字路径过长，未启用: " << m_path << std::endl;
+                return false;
+            }
+            if (int other = ControlClient::connectTo(m_path); other >= 0) {
+                ::close(other);
+                std::cerr << "另一个监控进程正在使用控制套接字: " << m_path << std::endl;
+                return false;
+            }
+            std::error_code ec;
+            std::filesystem::remove(m_path, ec);
+
+            m_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+            if (m_fd < 0) return false;
+            address.sun_family = AF_UNIX;
+            std::memcpy(address.sun_path, m_path.c_str(), m_path.size() + 1);
+            if (bind(m_fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0
+                || listen(m_fd, 16) != 0) {
+                std::cerr << "无法监听控制套接字: " << m_path << " - " << std::strerror(errno) << std::endl;
+                ::close(m_fd);
+                m_fd = -1;
+                return false;
+            }
+            // 只允许当前用户连接
+            std::filesystem::permissions(
+                m_path, std::filesystem::perms::owner_read | std::filesystem::perms::owner_write, ec);
+            m_thread = std::thread([this]() { acceptLoop(); });
+            return true;
+#endif
+        }
+
+        // 停止接收连接，等待正在处理的请求完成后删除套接字文件
+        void stop() {
+            if (m_stop.exchange(true)) return;
+            if (m_thread.joinable()) m_thread.join();
+            std::lock_guard lock(m_mutex);
+            for (auto& connection : m_connections) connection.thread.join();
+            m_connections.clear();
+#ifndef YUMECARD_PLATFORM_WINDOWS
+            if (m_fd >= 0) {
+                ::close(m_fd);
+                m_fd = -1;
+                std::error_code ec;
+                std::filesystem::remove(m_path, ec);
+            }
+#endif
+        }
+
+    private:
+        struct Connection {
+            std::thread                        thread;
+            std::shared_ptr<std::atomic<bool>> done;
+        };
+
+        std::string           m_path;
+        Handler               m_handler;
+        int                   m_fd = -1;
+        std::atomic<bool>     m_stop{false};
+        std::thread           m_thread;
+        std::mutex            m_mutex;
+        std::list<Connection> m_connections;
+
+#ifndef YUMECARD_PLATFORM_WINDOWS
+        // 每200毫秒检查一次停止标志；每个连接在自己的线程上处理，较慢的check请求不会阻塞其他命令
+        void acceptLoop() {
+            while (!m_stop) {
+                reapConnections();
+                pollfd descriptor{m_fd, POLLIN, 0};
+                if (poll(&descriptor, 1, 200) <= 0) continue;
+                int client = accept(m_fd, nullptr, nullptr);
+                if (client < 0) continue;
+                if (!sameUser(client)) {
+                    ::close(client);
+                    continue;
+                }
+
+                std::lock_guard lock(m_mutex);
+                if (m_connections.size() >= kMaxConnections) {
+                    nlohmann::json busy = {
+                        {   "ok",          false},
+                        {"error", "监控进程繁忙"}
+                    };
+                    ControlClient::writeAll(client, busy.dump() + "\n");
+                    ::close(client);
+                    continue;
+                }
+                auto done = std::make_shared<std::atomic<bool>>(false);
+                std::thread thread([this, client, done]() {
+                    serve(client);
+                    *done = true;
+                });
+                m_connections.push_back({std::move(thread), done});
+            }
+        }
+
+        // 只接受与监控进程同一用户的连接；套接字文件的权限在bind之后才收紧，不能只依赖文件权限
+        bool static sameUser(int client) {
+#ifdef SO_PEERCRED
+            ucred     credentials{};
+            socklen_t length = sizeof(credentials);
+            return getsockopt(client, SOL_SOCKET, SO_PEERCRED, &credentials, &length) == 0
+                && credentials.uid == geteuid();
+#else
+            uid_t uid = 0;
+            gid_t gid = 0;
+            return getpeereid(client, &uid, &gid) == 0 && uid == geteuid();
+#endif
+        }
+
+        void serve(int client) {
+            ControlClient::setTimeout(client, std::chrono::seconds(5));
+            std::string line;
+            if (!ControlClient::readLine(client, line, ControlClient::kMaxRequest)) {
+                ::close(client);
+                return;
+            }
+            nlohmann::json response;
+            try {
+                response = m_handler(nlohmann::json::parse(line));
+            } catch (std::exception const& e) {
+                response = {
+                    {   "ok",    false},
+                    {"error", e.what()}
+                };
+            }
+            ControlClient::writeAll(client, response.dump() + "\n");
+            ::close(client);
+        }
+
+        void reapConnections() {
+            std::lock_guard lock(m_mutex);
+            for (auto it = m_connections.begin(); it != m_connections.end();) {
+                if (!*it->done) {
+                    ++it;
+                    continue;
+                }
+                it->thread.join();
+                it = m_connections.erase(it);
+            }
+        }
+#endif
+    };
+
+} // namespace Yume
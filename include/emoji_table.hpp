@@ -0,0 +1,414 @@
+//
+// GitHub emoji短代码表与编译期完美哈希
+// 表在编译期构建（hash-and-displace），运行时查找为两次哈希加一次比较，不使用正则也不加载外部数据
+//
+
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <string_view>
+
+namespace Yume {
+
+    struct EmojiEntry {
+        std::string_view code;  // 不含冒号的短代码
+        std::string_view emoji; // UTF-8
+    };
+
+    // 常用GitHub短代码（含gitmoji全集）
+    inline constexpr EmojiEntry kEmojiEntries[] = {
+        {"+1", "👍"},
+        {"-1", "👎"},
+        {"100", "💯"},
+        {"abacus", "🧮"},
+        {"adhesive_bandage", "🩹"},
+        {"airplane", "✈️"},
+        {"alarm_clock", "⏰"},
+        {"alembic", "⚗️"},
+        {"alien", "👽"},
+        {"ambulance", "🚑"},
+        {"anchor", "⚓"},
+        {"apple", "🍎"},
+        {"arrow_down", "⬇️"},
+        {"arrow_left", "⬅️"},
+        {"arrow_right", "➡️"},
+        {"arrow_up", "⬆️"},
+        {"arrows_counterclockwise", "🔄"},
+        {"art", "🎨"},
+        {"baby", "👶"},
+        {"balloon", "🎈"},
+        {"bank", "🏦"},
+        {"bar_chart", "📊"},
+        {"battery", "🔋"},
+        {"beer", "🍺"},
+        {"beers", "🍻"},
+        {"bell", "🔔"},
+        {"bento", "🍱"},
+        {"bike", "🚲"},
+        {"blush", "😊"},
+        {"bomb", "💣"},
+        {"book", "📖"},
+        {"bookmark", "🔖"},
+        {"bookmark_tabs", "📑"},
+        {"books", "📚"},
+        {"boom", "💥"},
+        {"bricks", "🧱"},
+        {"broken_heart", "💔"},
+        {"broom", "🧹"},
+        {"bug", "🐛"},
+        {"building_construction", "🏗️"},
+        {"bulb", "💡"},
+        {"bus", "🚌"},
+        {"busts_in_silhouette", "👥"},
+        {"cactus", "🌵"},
+        {"cake", "🍰"},
+        {"calendar", "📆"},
+        {"camera", "📷"},
+        {"camera_flash", "📸"},
+        {"candle", "🕯️"},
+        {"car", "🚗"},
+        {"card_file_box", "🗃️"},
+        {"cat", "🐱"},
+        {"cd", "💿"},
+        {"chains", "⛓️"},
+        {"chart_with_downwards_trend", "📉"},
+        {"chart_with_upwards_trend", "📈"},
+        {"checkered_flag", "🏁"},
+        {"cherries", "🍒"},
+        {"cherry_blossom", "🌸"},
+        {"children_crossing", "🚸"},
+        {"clap", "👏"},
+        {"clipboard", "📋"},
+        {"closed_lock_with_key", "🔐"},
+        {"cloud", "☁️"},
+        {"clown_face", "🤡"},
+        {"coffee", "☕"},
+        {"coffin", "⚰️"},
+        {"collision", "💥"},
+        {"compass", "🧭"},
+        {"computer", "💻"},
+        {"confetti_ball", "🎊"},
+        {"construction", "🚧"},
+        {"construction_worker", "👷"},
+        {"cool", "🆒"},
+        {"couple", "👫"},
+        {"crescent_moon", "🌙"},
+        {"crossed_swords", "⚔️"},
+        {"crown", "👑"},
+        {"cry", "😢"},
+        {"dagger", "🗡️"},
+        {"dancer", "💃"},
+        {"dart", "🎯"},
+        {"date", "📅"},
+        {"desktop_computer", "🖥️"},
+        {"dizzy", "💫"},
+        {"dna", "🧬"},
+        {"dog", "🐶"},
+        {"droplet", "💧"},
+        {"earth_asia", "🌏"},
+        {"egg", "🥚"},
+        {"electric_plug", "🔌"},
+        {"email", "📧"},
+        {"envelope", "✉️"},
+        {"evergreen_tree", "🌲"},
+        {"exclamation", "❗"},
+        {"exploding_head", "🤯"},
+        {"eyes", "👀"},
+        {"facepalm", "🤦"},
+        {"factory", "🏭"},
+        {"family", "👪"},
+        {"fast_forward", "⏩"},
+        {"file_folder", "📁"},
+        {"fire", "🔥"},
+        {"firecracker", "🧨"},
+        {"flashlight", "🔦"},
+        {"floppy_disk", "💾"},
+        {"four_leaf_clover", "🍀"},
+        {"free", "🆓"},
+        {"game_die", "🎲"},
+        {"gear", "⚙️"},
+        {"gem", "💎"},
+        {"ghost", "👻"},
+        {"gift", "🎁"},
+        {"globe_with_meridians", "🌐"},
+        {"goal_net", "🥅"},
+        {"green_heart", "💚"},
+        {"grey_question", "❔"},
+        {"grinning", "😀"},
+        {"gun", "🔫"},
+        {"hammer", "🔨"},
+        {"hammer_and_pick", "⚒️"},
+        {"hammer_and_wrench", "🛠️"},
+        {"headphones", "🎧"},
+        {"hear_no_evil", "🙉"},
+        {"heart", "❤️"},
+        {"heart_eyes", "😍"},
+        {"heavy_check_mark", "✔️"},
+        {"heavy_exclamation_mark", "❗"},
+        {"heavy_minus_sign", "➖"},
+        {"heavy_plus_sign", "➕"},
+        {"hospital", "🏥"},
+        {"hourglass", "⌛"},
+        {"hourglass_flowing_sand", "⏳"},
+        {"house", "🏠"},
+        {"hugs", "🤗"},
+        {"inbox_tray", "📥"},
+        {"information_source", "ℹ️"},
+        {"iphone", "📱"},
+        {"japanese_goblin", "👺"},
+        {"japanese_ogre", "👹"},
+        {"jigsaw", "🧩"},
+        {"joy", "😂"},
+        {"key", "🔑"},
+        {"keyboard", "⌨️"},
+        {"label", "🏷️"},
+        {"lantern", "🏮"},
+        {"large_blue_circle", "🔵"},
+        {"laughing", "😆"},
+        {"link", "🔗"},
+        {"lipstick", "💄"},
+        {"lock", "🔒"},
+        {"lock_with_ink_pen", "🔏"},
+        {"loud_sound", "🔊"},
+        {"loudspeaker", "📢"},
+        {"mag", "🔍"},
+        {"mailbox", "📫"},
+        {"man", "👨"},
+        {"maple_leaf", "🍁"},
+        {"medal_sports", "🏅"},
+        {"mega", "📣"},
+        {"memo", "📝"},
+        {"microphone", "🎤"},
+        {"microscope", "🔬"},
+        {"money_mouth_face", "🤑"},
+        {"money_with_wings", "💸"},
+        {"moneybag", "💰"},
+        {"monocle_face", "🧐"},
+        {"moon", "🌔"},
+        {"movie_camera", "🎥"},
+        {"muscle", "💪"},
+        {"mushroom", "🍄"},
+        {"musical_note", "🎵"},
+        {"mute", "🔇"},
+        {"necktie", "👔"},
+        {"nerd_face", "🤓"},
+        {"new", "🆕"},
+        {"newspaper", "📰"},
+        {"no_bell", "🔕"},
+        {"no_entry", "⛔"},
+        {"no_entry_sign", "🚫"},
+        {"notes", "🎶"},
+        {"nut_and_bolt", "🔩"},
+        {"ocean", "🌊"},
+        {"ok", "🆗"},
+        {"ok_hand", "👌"},
+        {"open_file_folder", "📂"},
+        {"outbox_tray", "📤"},
+        {"package", "📦"},
+        {"page_facing_up", "📄"},
+        {"paperclip", "📎"},
+        {"partying_face", "🥳"},
+        {"passport_control", "🛂"},
+        {"pencil", "📝"},
+        {"pencil2", "✏️"},
+        {"penguin", "🐧"},
+        {"pick", "⛏️"},
+        {"pill", "💊"},
+        {"pirate_flag", "🏴‍☠️"},
+        {"pizza", "🍕"},
+        {"point_right", "👉"},
+        {"point_up", "☝️"},
+        {"poop", "💩"},
+        {"pray", "🙏"},
+        {"pushpin", "📌"},
+        {"question", "❓"},
+        {"radio", "📻"},
+        {"rainbow", "🌈"},
+        {"rainbow_flag", "🏳️‍🌈"},
+        {"raised_hands", "🙌"},
+        {"recycle", "♻️"},
+        {"red_circle", "🔴"},
+        {"red_envelope", "🧧"},
+        {"repeat", "🔁"},
+        {"rewind", "⏪"},
+        {"robot", "🤖"},
+        {"rocket", "🚀"},
+        {"rose", "🌹"},
+        {"rotating_light", "🚨"},
+        {"round_pushpin", "📍"},
+        {"runner", "🏃"},
+        {"safety_vest", "🦺"},
+        {"satellite", "📡"},
+        {"school", "🏫"},
+        {"scissors", "✂️"},
+        {"scroll", "📜"},
+        {"see_no_evil", "🙈"},
+        {"seedling", "🌱"},
+        {"shield", "🛡️"},
+        {"ship", "🚢"},
+        {"shrug", "🤷"},
+        {"skull", "💀"},
+        {"smile", "😄"},
+        {"smiley", "😃"},
+        {"snake", "🐍"},
+        {"snowflake", "❄️"},
+        {"soap", "🧼"},
+        {"sob", "😭"},
+        {"sos", "🆘"},
+        {"sparkle", "❇️"},
+        {"sparkles", "✨"},
+        {"speak_no_evil", "🙊"},
+        {"speech_balloon", "💬"},
+        {"star", "⭐"},
+        {"star2", "🌟"},
+        {"stethoscope", "🩺"},
+        {"stopwatch", "⏱️"},
+        {"straight_ruler", "📏"},
+        {"sun_with_face", "🌞"},
+        {"sunglasses", "😎"},
+        {"sunny", "☀️"},
+        {"sweat_drops", "💦"},
+        {"sweat_smile", "😅"},
+        {"syringe", "💉"},
+        {"tada", "🎉"},
+        {"technologist", "🧑‍💻"},
+        {"teddy_bear", "🧸"},
+        {"telescope", "🔭"},
+        {"test_tube", "🧪"},
+        {"thinking", "🤔"},
+        {"thread", "🧵"},
+        {"thumbsdown", "👎"},
+        {"thumbsup", "👍"},
+        {"tomato", "🍅"},
+        {"train", "🚆"},
+        {"tree", "🌳"},
+        {"triangular_flag_on_post", "🚩"},
+        {"triangular_ruler", "📐"},
+        {"trophy", "🏆"},
+        {"truck", "🚚"},
+        {"tv", "📺"},
+        {"twisted_rightwards_arrows", "🔀"},
+        {"unlock", "🔓"},
+        {"up", "🆙"},
+        {"upside_down_face", "🙃"},
+        {"v", "✌️"},
+        {"vertical_traffic_light", "🚦"},
+        {"video_game", "🎮"},
+        {"walking", "🚶"},
+        {"warning", "⚠️"},
+        {"wastebasket", "🗑️"},
+        {"watch", "⌚"},
+        {"wave", "👋"},
+        {"whale", "🐳"},
+        {"wheelchair", "♿"},
+        {"white_check_mark", "✅"},
+        {"white_circle", "⚪"},
+        {"white_flag", "🏳️"},
+        {"wink", "😉"},
+        {"woman", "👩"},
+        {"wrench", "🔧"},
+        {"x", "❌"},
+        {"zap", "⚡"},
+        {"zipper_mouth_face", "🤐"},
+        {"zzz", "💤"},
+    };
+
+    namespace emoji_detail {
+        inline constexpr size_t kEntryCount  = std::size(kEmojiEntries);
+        inline constexpr size_t kBucketCount = kEntryCount / 4 + 1;
+        inline constexpr size_t kSlotCount   = [] {
+            size_t size = 1;
+            while (size < kEntryCount * 2) size <<= 1;
+            return size;
+        }();
+
+        // 带种子的FNV-1a，末尾做一次雪崩混合
+        constexpr uint32_t hash(std::string_view key, uint32_t seed) {
+            uint32_t h = 2166136261u ^ (seed * 0x9E3779B9u);
+            for (char c : key) {
+                h ^= static_cast<unsigned char>(c);
+                h *= 16777619u;
+            }
+            h ^= h >> 16;
+            h *= 0x85EBCA6Bu;
+            h ^= h >> 13;
+            h *= 0xC2B2AE35u;
+            h ^= h >> 16;
+            return h;
+        }
+
+        struct PerfectHash {
+            std::array<uint16_t, kBucketCount> seeds{};
+            std::array<int16_t, kSlotCount>    slots{};
+            bool                               ok = false;
+        };
+
+        // 编译期构建：按桶大小降序为每个桶寻找一个种子，使桶内所有键落在互不冲突的空槽
+        consteval PerfectHash build() {
+            PerfectHash table;
+            for (auto& slot : table.slots) slot = -1;
+
+            std::array<size_t, kEntryCount>  bucketOf{};
+            std::array<size_t, kBucketCount> bucketSize{};
+            for (size_t i = 0; i < kEntryCount; ++i) {
+                bucketOf[i] = hash(kEmojiEntries[i].code, 0) % kBucketCount;
+                ++bucketSize[bucketOf[i]];
+            }
+
+            std::array<size_t, kBucketCount> order{};
+            for (size_t i = 0; i < kBucketCount; ++i) order[i] = i;
+            for (size_t i = 1; i < kBucketCount; ++i)
+                for (size_t j = i; j > 0 && bucketSize[order[j - 1]] < bucketSize[order[j]]; --j) {
+                    size_t tmp   = order[j];
+                    order[j]     = order[j - 1];
+                    order[j - 1] = tmp;
+                }
+
+            for (size_t b : order) {
+                if (bucketSize[b] == 0) continue;
+                bool placed = false;
+                for (uint32_t seed = 1; seed < 65536 && !placed; ++seed) {
+                    std::array<size_t, kEntryCount> chosen{};
+                    size_t                          count = 0;
+                    bool                            fits  = true;
+                    for (size_t i = 0; i < kEntryCount && fits; ++i) {
+                        if (bucketOf[i] != b) continue;
+                        size_t slot = hash(kEmojiEntries[i].code, seed) % kSlotCount;
+                        if (table.slots[slot] != -1) fits = false;
+                        for (size_t k = 0; k < count && fits; ++k)
+                            if (chosen[k] == slot) fits = false;
+                        chosen[count++] = slot;
+                    }
+                    if (!fits) continue;
+
+                    count = 0;
+                    for (size_t i = 0; i < kEntryCount; ++i)
+                        if (bucketOf[i] == b) table.slots[chosen[count++]] = static_cast<int16_t>(i);
+                    table.seeds[b] = static_cast<uint16_t>(seed);
+                    placed         = true;
+                }
+                if (!placed) return table;
+            }
+            table.ok = true;
+            return table;
+        }
+
+        inline constexpr PerfectHash kTable = build();
+        static_assert(kTable.ok, "emoji短代码表存在重复键或无法构建完美哈希");
+    } // namespace emoji_detail
+
+    // 查找短代码（不含冒号），未知时返回空
+    constexpr std::string_view lookupEmoji(std::string_view code) {
+        using namespace emoji_detail;
+        uint32_t seed = kTable.seeds[hash(code, 0) % kBucketCount];
+        if (seed == 0) return {};
+        int16_t index = kTable.slots[hash(code, seed) % kSlotCount];
+        if (index < 0 || kEmojiEntries[index].code != code) return {};
+        return kEmojiEntries[index].emoji;
+    }
+
+    static_assert(lookupEmoji("sparkles") == "✨");
+    static_assert(lookupEmoji("not_an_emoji").empty());
+
+} // namespace Yume
@@ -4,6 +4,9 @@
 
 #pragma once
 
+#include <mutex>
+#include <tuple>
+
 #include "head.hpp"
 
 namespace Yume {
@@ -28,7 +31,6 @@ namespace Yume {
             m_curl(nullptr),
             // m_token(std::move(token)), // m_token will be loaded from config or set via setter
             m_initialized(false),
-            m_res(CURLE_OK),
             m_config_path(std::move(config_path)) {
             loadConfig(); // Load config on initialization
             if (m_config.contains("GitHub") && m_config["GitHub"].contains("token")) {
@@ -66,15 +68,111 @@ namespace Yume {
                 curl_easy_cleanup(m_curl);
                 m_curl = nullptr;
             }
+            for (CURL* handle : m_idleHandles) curl_easy_cleanup(handle);
+            m_idleHandles.clear();
             curl_global_cleanup();
             m_initialized = false;
         }
 
+        // 配置重新加载后更新令牌
+        void setToken(std::string const& token) {
+            std::lock_guard lock(m_tokenMutex);
+            m_token = token;
+        }
+
         // 获取仓库最新提交
         nlohmann::json getCommits(std::string const& user, std::string const& repo, int limit = 10) {
-            std::string url = "https://api.github.com/repos/" + user + "/" + repo + "/commits";
-            url += "?per_page=" + std::to_string(limit);
-            return performGetRequest(url);
+            return performGetRequest(commitsUrl(user, repo, limit));
+        }
+
+        // 获取仓库最新提交的原始响应，由调用方在检查内存区中解析；请求失败时返回std::nullopt
+        std::optional<std::string> getCommitsText(std::string const& user, std::string const& repo,
+                                                  int limit = 10) {
+            return performGetText(commitsUrl(user, repo, limit));
+        }
+
+        // 并发获取多个提交的详情（含stats与files），返回 sha -> 响应；失败的SHA不出现在结果中
+        std::map<std::string, nlohmann::json> getCommitDetails(std::string const&              user,
+                                                               std::string const&              repo,
+                                                               std::vector<std::string> const& shas,
+                                                               long maxConcurrent = 6) {
+            std::map<std::string, nlohmann::json> results;
+            std::string baseUrl = "https://api.github.com/repos/" + user + "/" + repo + "/commits/";
+            std::vector<std::string> urls;
+            urls.reserve(shas.size());
+            for (auto const& sha : shas) urls.push_back(baseUrl + sha);
+
+            auto responses = performMultiGet(urls, maxConcurrent);
+            for (size_t i = 0; i < responses.size(); ++i)
+                if (responses[i].ok()) results[shas[i]] = std::move(responses[i].body);
+            return results;
+        }
+
+        // 并发查询多个仓库分支的最新提交；status为0表示网络错误，404表示仓库或分支不存在
+        struct BranchHead {
+            long        status = 0;
+            std::string sha;
+        };
+
+        std::vector<BranchHead> getBranchHeads(
+            std::vector<std::tuple<std::string, std::string, std::string>> const& branches,
+            long                                                               maxConcurrent = 8) {
+            std::vector<std::string> urls;
+            urls.reserve(branches.size());
+            for (auto const& [user, repo, branch] : branches)
+                urls.push_back("https://api.github.com/repos/" + user + "/" + repo + "/branches/"
+                               + encodePathSegment(branch));
+
+            auto                    responses = performMultiGet(urls, maxConcurrent);
+            std::vector<BranchHead> heads(responses.size());
+            for (size_t i = 0; i < responses.size(); ++i) {
+                heads[i].status = responses[i].status;
+                auto const& body = responses[i].body;
+                if (responses[i].ok() && body.contains("commit") && body["commit"].contains("sha"))
+                    heads[i].sha = body["commit"]["sha"].get<std::string>();
+            }
+            return heads;
+        }
+
+        // 并发查询多个仓库的默认分支；status含义与getBranchHeads相同，失败时branch为空
+        struct DefaultBranch {
+            long        status = 0;
+            std::string branch;
+        };
+
+        std::vector<DefaultBranch> getDefaultBranches(
+            std::vector<std::pair<std::string, std::string>> const& repos, long maxConcurrent = 8) {
+            std::vector<std::string> urls;
+            urls.reserve(repos.size());
+            for (auto const& [user, repo] : repos)
+                urls.push_back("https://api.github.com/repos/" + user + "/" + repo);
+
+            auto                       responses = performMultiGet(urls, maxConcurrent);
+            std::vector<DefaultBranch> branches(responses.size());
+            for (size_t i = 0; i < responses.size(); ++i) {
+                branches[i].status = responses[i].status;
+                auto const& body   = responses[i].body;
+                if (responses[i].ok() && body.is_object())
+                    branches[i].branch = body.value("default_branch", "");
+            }
+            return branches;
+        }
+
+        // 分支名等作为URL路径的一段时转义，'/'也会被转义
+        std::string static encodePathSegment(std::string_view text) {
+            static constexpr char kDigits[] = "0123456789ABCDEF";
+            std::string           encoded;
+            encoded.reserve(text.size());
+            for (unsigned char c : text) {
+                if (std::isalnum(c) || c == '-' || c == '.' || c == '_' || c == '~') {
+                    encoded += static_cast<char>(c);
+                } else {
+                    encoded += '%';
+                    encoded += kDigits[c >> 4];
+                    encoded += kDigits[c & 0x0f];
+                }
+            }
+            return encoded;
         }
 
         // 获取仓库最新Issue
@@ -109,63 +207,202 @@ namespace Yume {
         CURL*       m_curl;
         std::string m_token;
         bool        m_initialized;
-        CURLcode    m_res;
         std::string m_config_path;
+        // 多个线程同时请求时，m_curl之外的连接句柄在这里复用
+        std::vector<CURL*> m_idleHandles;
+        std::mutex         m_handleMutex;
+        mutable std::mutex m_tokenMutex;
         // nlohmann::json m_config; // Moved to public for now
 
+        std::string static commitsUrl(std::string const& user, std::string const& repo, int limit) {
+            return "https://api.github.com/repos/" + user + "/" + repo + "/commits?per_page="
+                 + std::to_string(limit);
+        }
+
         // Helper function to perform GET requests
         nlohmann::json performGetRequest(std::string const& url) {
+            std::optional<std::string> body = performGetText(url);
+            if (!body) return nlohmann::json::object(); // Return empty JSON object on error
+            try {
+                return nlohmann::json::parse(*body);
+            } catch (nlohmann::json::parse_error& e) {
+                std::cerr << "JSON parse error: " << e.what() << "\nResponse was: " << *body << std::endl;
+                return nlohmann::json::object(); // Return empty JSON object on parse error
+            }
+        }
+
+        // 请求并返回响应正文；失败或响应为空时打印原因并返回std::nullopt
+        std::optional<std::string> performGetText(std::string const& url) {
             if (!m_initialized && !initialize()) {
                 std::cerr << "CURL not initialized for performGetRequest" << std::endl;
-                return nlohmann::json::object(); // Return empty JSON object on error
+                return std::nullopt;
             }
 
             std::string        readBuffer;
-            struct curl_slist* headers = nullptr;
-            headers = curl_slist_append(headers, "Accept: application/vnd.github.v3+json");
-            headers = curl_slist_append(headers, "User-Agent: YumeCard-App"); // Set a User-Agent
-            if (!m_token.empty()) {
-                std::string authHeader = "Authorization: token " + m_token;
-                headers                = curl_slist_append(headers, authHeader.c_str());
+            struct curl_slist* headers = buildHeaders();
+            CURL*              curl    = acquireHandle();
+            if (!curl) {
+                curl_slist_free_all(headers);
+                return std::nullopt;
             }
+            configureRequest(curl, url, headers, &readBuffer);
 
-            curl_easy_setopt(m_curl, CURLOPT_URL, url.c_str());
-            curl_easy_setopt(m_curl, CURLOPT_HTTPHEADER, headers);
-            curl_easy_setopt(m_curl, CURLOPT_WRITEFUNCTION,
-                             Yume::WriteCallback); // Ensure Yume::WriteCallback is accessible
-            curl_easy_setopt(m_curl, CURLOPT_WRITEDATA, &readBuffer);
-            curl_easy_setopt(m_curl, CURLOPT_TIMEOUT, 15L);       // 15 seconds timeout
-            curl_easy_setopt(m_curl, CURLOPT_SSL_VERIFYPEER, 1L); // Verify SSL peer
-            curl_easy_setopt(m_curl, CURLOPT_SSL_VERIFYHOST, 2L); // Verify SSL host
-            // curl_easy_setopt(m_curl, CURLOPT_VERBOSE, 1L); // Uncomment for debugging CURL requests
-
-            m_res = curl_easy_perform(m_curl);
+            CURLcode res = curl_easy_perform(curl);
             curl_slist_free_all(headers);
+            long http_code = 0;
+            curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &http_code);
+            releaseHandle(curl);
 
-            if (m_res != CURLE_OK) {
-                std::cerr << "curl_easy_perform() failed: " << curl_easy_strerror(m_res) << std::endl;
-                return nlohmann::json::object();
+            if (res != CURLE_OK) {
+                std::cerr << "curl_easy_perform() failed: " << curl_easy_strerror(res) << std::endl;
+                return std::nullopt;
             }
 
-            long http_code = 0;
-            curl_easy_getinfo(m_curl, CURLINFO_RESPONSE_CODE, &http_code);
             if (http_code >= 400) {
                 std::cerr << "HTTP error " << http_code << " for URL: " << url << std::endl;
                 std::cerr << "Response: " << readBuffer << std::endl;
-                return nlohmann::json::object(); // Or a JSON object with an error field
+                return std::nullopt;
             }
 
-            try {
-                if (readBuffer.empty()) {
-                    std::cerr << "Empty response from server for URL: " << url << std::endl;
-                    return nlohmann::json::object(); // Return empty JSON if response is empty
+            if (readBuffer.empty()) {
+                std::cerr << "Empty response from server for URL: " << url << std::endl;
+                return std::nullopt;
+            }
+            return readBuffer;
+        }
+
+        struct Response {
+            long           status = 0; // HTTP状态码，网络错误时为0
+            nlohmann::json body;
+
+            bool ok() const { return status > 0 && status < 400 && !body.is_null(); }
+        };
+
+        // 所有请求共享一个curl multi句柄，同时进行的连接数不超过maxConcurrent；结果与urls一一对应
+        std::vector<Response> performMultiGet(std::vector<std::string> const& urls, long maxConcurrent) {
+            std::vector<Response> responses(urls.size());
+            if (urls.empty()) return responses;
+            if (!m_initialized && !initialize()) return responses;
+
+            struct Transfer {
+                size_t      index = 0;
+                std::string body;
+                CURL*       easy = nullptr;
+            };
+
+            CURLM* multi = curl_multi_init();
+            if (!multi) {
+                std::cerr << "curl_multi_init() failed" << std::endl;
+                return responses;
+            }
+            curl_multi_setopt(multi, CURLMOPT_MAX_TOTAL_CONNECTIONS, maxConcurrent);
+
+            struct curl_slist*    headers = buildHeaders();
+            std::vector<Transfer> transfers(urls.size());
+            for (size_t i = 0; i < urls.size(); ++i) {
+                Transfer& transfer = transfers[i];
+                transfer.index     = i;
+                transfer.easy      = curl_easy_init();
+                if (!transfer.easy) continue;
+                configureRequest(transfer.easy, urls[i], headers, &transfer.body);
+                curl_easy_setopt(transfer.easy, CURLOPT_PRIVATE, &transfer);
+                curl_multi_add_handle(multi, transfer.easy);
+            }
+
+            int running = 0;
+            do {
+                CURLMcode code = curl_multi_perform(multi, &running);
+                if (code == CURLM_OK && running) code = curl_multi_poll(multi, nullptr, 0, 1000, nullptr);
+                if (code != CURLM_OK) {
+                    std::cerr << "curl_multi failed: " << curl_multi_strerror(code) << std::endl;
+                    break;
                 }
-                return nlohmann::json::parse(readBuffer);
-            } catch (nlohmann::json::parse_error& e) {
-                std::cerr << "JSON parse error: " << e.what() << "\nResponse was: " << readBuffer
-                          << std::endl;
-                return nlohmann::json::object(); // Return empty JSON object on parse error
+            } while (running);
+
+            int      pending = 0;
+            CURLMsg* message = nullptr;
+            while ((message = curl_multi_info_read(multi, &pending))) {
+                if (message->msg != CURLMSG_DONE) continue;
+                Transfer* transfer = nullptr;
+                curl_easy_getinfo(message->easy_handle, CURLINFO_PRIVATE, &transfer);
+                std::string const& url = urls[transfer->index];
+
+                if (message->data.result != CURLE_OK) {
+                    std::cerr << "请求失败: " << url << " - " << curl_easy_strerror(message->data.result)
+                              << std::endl;
+                    continue;
+                }
+                Response& response = responses[transfer->index];
+                curl_easy_getinfo(message->easy_handle, CURLINFO_RESPONSE_CODE, &response.status);
+                if (response.status >= 400) {
+                    std::cerr << "HTTP error " << response.status << " for URL: " << url << std::endl;
+                    continue;
+                }
+                try {
+                    response.body = nlohmann::json::parse(transfer->body);
+                } catch (nlohmann::json::parse_error& e) {
+                    std::cerr << "JSON parse error: " << e.what() << " for URL: " << url << std::endl;
+                }
+            }
+
+            for (auto& transfer : transfers) {
+                if (!transfer.easy) continue;
+                curl_multi_remove_handle(multi, transfer.easy);
+                curl_easy_cleanup(transfer.easy);
+            }
+            curl_multi_cleanup(multi);
+            curl_slist_free_all(headers);
+            return responses;
+        }
+
+        // 取一个空闲的easy句柄（保留各自的连接缓存），没有时新建
+        CURL* acquireHandle() {
+            std::lock_guard lock(m_handleMutex);
+            if (m_curl) return std::exchange(m_curl, nullptr);
+            if (!m_idleHandles.empty()) {
+                CURL* handle = m_idleHandles.back();
+                m_idleHandles.pop_back();
+                return handle;
+            }
+            CURL* handle = curl_easy_init();
+            if (!handle) std::cerr << "curl_easy_init() failed" << std::endl;
+            return handle;
+        }
+
+        void releaseHandle(CURL* handle) {
+            std::lock_guard lock(m_handleMutex);
+            curl_easy_reset(handle);
+            m_idleHandles.push_back(handle);
+        }
+
+        // GitHub API通用请求头，调用方负责curl_slist_free_all
+        struct curl_slist* buildHeaders() const {
+            struct curl_slist* headers = nullptr;
+            headers = curl_slist_append(headers, "Accept: application/vnd.github.v3+json");
+            headers = curl_slist_append(headers, "User-Agent: YumeCard-App"); // Set a User-Agent
+            std::string token;
+            {
+                std::lock_guard lock(m_tokenMutex);
+                token = m_token;
             }
+            if (!token.empty()) {
+                std::string authHeader = "Authorization: token " + token;
+                headers                = curl_slist_append(headers, authHeader.c_str());
+            }
+            return headers;
+        }
+
+        void static configureRequest(CURL* curl, std::string const& url, struct curl_slist* headers,
+                                     std::string* body) {
+            curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
+            curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headers);
+            curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION,
+                             Yume::WriteCallback); // Ensure Yume::WriteCallback is accessible
+            curl_easy_setopt(curl, CURLOPT_WRITEDATA, body);
+            curl_easy_setopt(curl, CURLOPT_TIMEOUT, 15L);       // 15 seconds timeout
+            curl_easy_setopt(curl, CURLOPT_SSL_VERIFYPEER, 1L); // Verify SSL peer
+            curl_easy_setopt(curl, CURLOPT_SSL_VERIFYHOST, 2L); // Verify SSL host
+            // curl_easy_setopt(curl, CURLOPT_VERBOSE, 1L); // Uncomment for debugging CURL requests
         }
 
         // Load config from file
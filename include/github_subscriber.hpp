@@ -4,31 +4,73 @@
 
 #pragma once
 
+#include <condition_variable>
+#include <deque>
+#include <future>
+#include <set>
+#include <stop_token>
+#include <unordered_set>
+
+#include "adaptive_polling.hpp"
+#include "card_coalescer.hpp"
+#include "check_arena.hpp"
+#include "check_pipeline.hpp"
+#include "commit_details.hpp"
+#include "commit_record.hpp"
+#include "config_service.hpp"
+#include "control_socket.hpp"
 #include "github_api.hpp"
 #include "head.hpp"
+#include "history_store.hpp"
+#include "message_formatter.hpp"
 #include "read_config.hpp"
 #include "screenshot.hpp"
 #include "set_config.hpp"
+#include "shard_coordinator.hpp"
+#include "state_journal.hpp"
+#include "subscription_store.hpp"
+#include "timer_wheel.hpp"
 
 namespace Yume {
     class GitHubSubscriber {
     public:
-        // 使用map存储commit信息，key为sha，value为包含其他commit信息的vector
-        // vector elements: 0:date, 1:author, 2:repo_from_url, 3:html_url, 4:message, 5:avatar_url
-        using CommitMap = std::map<std::string, std::vector<std::string>>;
+        // 通过控制套接字请求的check最多等待检查流水线给出结果的时间
+        static constexpr std::chrono::seconds kControlCheckTimeout{120};
 
+        // worker_id非空时以分片模式运行：状态与历史写入该工作进程自己的目录，只检查归属自己的仓库
         explicit GitHubSubscriber(std::string config_path = "./config/config.json",
-                                  std::string style_dir = "./Style", std::string output_dir = "./Style"):
+                                  std::string style_dir = "./Style", std::string output_dir = "./Style",
+                                  std::string worker_id = ""):
             m_config_path(std::move(config_path)),
             m_style_dir(std::move(style_dir)),
             m_output_dir(std::move(output_dir)),
-            m_readConfig(m_config_path),
-            m_githubAPI(m_readConfig.getToken(), m_config_path) {
+            m_worker_id(std::move(worker_id)),
+            m_configService(m_config_path),
+            m_githubAPI(m_configService.snapshot()->getToken(), m_config_path),
+            m_screenshotManager(m_style_dir),
+            m_state(StateJournal::directoryFor(m_config_path, m_worker_id)),
+            m_store(SubscriptionStore::directoryFor(m_config_path)),
+            m_history(HistoryStore::directoryFor(m_config_path, m_worker_id)) {
             if (!m_githubAPI.initialize()) std::cerr << "GitHub API初始化失败！" << std::endl;
+            if (!m_worker_id.empty()) {
+                std::string clusterDir = ShardCoordinator::directoryFor(m_config_path);
+                m_shard                = std::make_unique<ShardCoordinator>(clusterDir, m_worker_id);
+            }
+            migrateLegacyState();
         }
 
         ~GitHubSubscriber() = default;
 
+        // 分片模式下取得本工作进程的租约，同名工作进程仍在运行时失败；非分片模式直接返回true
+        bool joinCluster() {
+            if (!m_shard) return true;
+            if (!m_shard->acquire()) return false;
+            std::cout << "工作进程 " << m_worker_id << " 已加入，当前成员: " << describeMembers()
+                      << std::endl;
+            std::cout << "新成员需等待 " << ShardCoordinator::kHandoff << " 秒后接手仓库" << std::endl;
+            return true;
+        }
+
         // 添加新仓库并立即获取最新commit
         bool addRepository(std::string const& owner, std::string const& repo,
                            std::string const& branch = "main") {
@@ -43,7 +85,15 @@ namespace Yume {
             }
 
             Set_config setConfig(config_json, m_config_path);
-            setConfig.addRepository(owner, repo, branch);
+            if (m_store.available() && !setConfig.repositories().contains(owner, repo)) {
+                RepositoryEntry entry;
+                entry.owner  = owner;
+                entry.repo   = repo;
+                entry.branch = branch.empty() ? "main" : branch;
+                m_store.add(entry);
+            } else if (setConfig.addRepository(owner, repo, branch)) {
+                m_configService.reload(); // 不等文件监视通知
+            }
 
             // 然后获取该仓库的最新commit
             nlohmann::json commits_json = m_githubAPI.getCommits(owner, repo, 1); // Renamed
@@ -56,278 +106,901 @@ namespace Yume {
                 return false;
             }
 
-            // 获取最新commit的SHA并更新配置文件
+            // 获取最新commit的SHA并记录到状态日志
             std::string latestSha = commits_json[0]["sha"].get<std::string>();
-            setConfig.setLastSha(owner, repo, latestSha);
+            m_state.setLastSha(StateJournal::key(owner, repo), latestSha);
+            m_state.sync();
 
             std::cout << "成功添加仓库 " << owner << "/" << repo << " 并获取最新commit SHA: " << latestSha
                       << std::endl;
             return true;
         }
 
-        // 检查仓库更新
-        CommitMap checkRepositoryUpdates(std::string const& owner, std::string const& repo,
-                                         int limit = 10) {
-            CommitMap newCommits;
-
-            // 获取仓库当前记录的SHA
-            std::string lastSha       = m_readConfig.getLastSha(owner, repo);
-            std::string currentBranch = m_readConfig.getBranch(owner, repo);
-            if (currentBranch.empty()) currentBranch = "main"; // Default if not found
-
-            // 获取仓库最新的commits
+        // 检查仓库更新，依次执行抓取、解析、模板和截图各阶段（check命令使用）
+        CommitBatch checkRepositoryUpdates(std::string const& owner, std::string const& repo,
+                                           int limit = 10) {
             // GitHubAPI::getCommits 只接受3个参数 (owner, repo, limit)
             // 暂时不支持指定分支，总是获取默认分支的提交
-            nlohmann::json commits_json = m_githubAPI.getCommits(owner, repo, limit);
-            if (commits_json.empty() || !commits_json.is_array()) {
-                std::cerr << "获取仓库 " << owner << "/" << repo << " 的commit失败！" << std::endl;
-                return newCommits;
-            }
-
-            // 解析commit信息并创建commit map
-            CommitMap commitMap = parseCommits(commits_json);
-
-            if (lastSha.empty()) {
-                if (!commitMap.empty()) {
-                    auto latestCommit =
-                        commitMap.begin(); // map is ordered by SHA (string comparison, not time)
-                                           // For "latest", we'd typically want the first from API
-                                           // response if it's time-sorted The parseCommits populates in
-                                           // API order, so begin() is the newest from the fetched batch
-                    std::string latestShaToStore = latestCommit->first;
-                    updateLastSha(owner, repo, latestShaToStore);
-                    // Pass correct number of arguments to generateCommitScreenshot
-                    generateCommitScreenshot(owner, repo, currentBranch,
-                                             m_readConfig.getDescription(owner, repo), "", commitMap);
-                }
-                return commitMap; // Return all fetched if no previous SHA
-            }
-
-            bool      foundLastSha = false;
-            CommitMap tempCommitsInApiOrder; // To preserve API order for selecting "new" ones
+            std::optional<std::string> body = m_githubAPI.getCommitsText(owner, repo, limit);
+            CardJob                    card = selectNewCommits(owner, repo, body.value_or(""));
+            if (!card.commits.empty()) generateCommitScreenshot(card);
+            return card.commits;
+        }
 
-            // Iterate in the order received from API (which parseCommits preserves if jsonArray is
-            // ordered) nlohmann::json keeps insertion order for objects if they are added like that.
-            // std::map sorts by key. So commitMap is sorted by SHA.
-            // We need to compare against `lastSha` using the API's order of commits (usually newest
-            // first).
+        // 定期检查所有仓库更新：每个仓库在时间轮中有自己的到期时间（带随机抖动），
+        // 到期的仓库进入检查流水线：抓取（I/O线程）→ 解析、模板（CPU线程）→ 截图（截图线程），
+        // 解析后立即按自适应间隔重新排入时间轮，不必等待截图完成
+        // intervalMinutes用于还没有提交数据的仓库；stop被请求后在期限内收尾，并保存未完成的检查队列
+        void startPeriodicCheck(unsigned int intervalMinutes = 10, std::stop_token stop = {}) {
+            auto          config     = m_configService.snapshot();
+            size_t        ioThreads  = config->getWorkerCount();
+            size_t        cpuThreads = std::clamp<size_t>(std::thread::hardware_concurrency(), 1, 4);
+            size_t        renderers  = config->getRendererCount();
+            CheckPipeline pipeline(ioThreads, cpuThreads, renderers);
+            Monitor       monitor{TimerWheel<std::string>(StateJournal::now()), {}, {}, {}, pipeline,
+                            static_cast<int64_t>(intervalMinutes) * 60};
+            std::cout << "使用 " << ioThreads << " 个抓取线程、" << cpuThreads << " 个解析线程、" << renderers
+                      << " 个截图线程检查仓库" << std::endl;
 
-            std::vector<std::pair<std::string, std::vector<std::string>>> apiOrderedCommits;
-            for (auto const& commitJson : commits_json) {
-                std::string sha = commitJson["sha"].get<std::string>();
-                if (commitMap.count(sha)) // Ensure it was parsed correctly
-                    apiOrderedCommits.push_back({sha, commitMap.at(sha)});
+            // 沿用其他工作进程（或单进程模式）记录的更新状态
+            adoptForeignState();
+            std::deque<std::string> backlog; // 已到期、等待准入的仓库
+            // 上次停止时尚未完成检查的仓库排在最前面，其余仓库沿用状态中记录的到期时间
+            StateJournal::Queue saved = m_state.takeQueue();
+            for (auto& key : saved.repos)
+                if (monitor.scheduled.try_emplace(key, kQueued).second) backlog.push_back(std::move(key));
+            if (!backlog.empty()) std::cout << "继续上次未完成的 " << backlog.size() << " 个检查" << std::endl;
+            // 上次没来得及生成的卡片：提交已记录为最新，不会再被发现，按早已到期的合并卡片立即生成
+            size_t restored = 0;
+            for (auto const& item : saved.cards) {
+                CardJob card = CardJob::fromJson(item);
+                if (card.commits.empty()) continue;
+                holdCard(monitor, card);
+                std::string key = StateJournal::key(card.owner, card.repo);
+                monitor.coalescer.add(key, std::move(card), 0, mergeCards);
+                ++restored;
             }
+            if (restored > 0) std::cout << "恢复上次未生成的 " << restored << " 张卡片" << std::endl;
 
-            for (auto const& pair : apiOrderedCommits) {
-                std::string const&              sha  = pair.first;
-                std::vector<std::string> const& info = pair.second;
-                if (sha == lastSha) {
-                    foundLastSha = true;
-                    break;
-                }
-                newCommits[sha] = info; // Add to newCommits, will be in SHA-sorted order
-            }
+            // check、add、list、status命令交给本进程处理
+            ControlServer server(ControlClient::pathFor(m_config_path, m_worker_id),
+                                 [this, &monitor](nlohmann::json const& request) {
+                                     return handleControl(monitor, request);
+                                 });
+            if (server.start()) std::cout << "控制套接字已启用，命令将由本进程处理" << std::endl;
 
-            if (!foundLastSha)          // lastSha not in the latest 'limit' commits
-                newCommits = commitMap; // return all 'limit' commits
+            uint64_t syncedVersion = 0;
+            int64_t  lastSync      = 0;
+            while (!stop.stop_requested()) {
+                // 配置变化时由ConfigService重新解析，这里只取当前快照
+                config = m_configService.snapshot();
+                m_githubAPI.setToken(config->getToken());
+                int64_t now = StateJournal::now();
 
-            if (!newCommits.empty()) {
-                std::string latestShaToStore = apiOrderedCommits.front().first;
-                updateLastSha(owner, repo, latestShaToStore);
-                // Pass correct number of arguments to generateCommitScreenshot
-                generateCommitScreenshot(owner, repo, currentBranch,
-                                         m_readConfig.getDescription(owner, repo), "", newCommits);
-            }
-
-            return newCommits;
-        }
+                // 续约并读取分片成员；负责的仓库变化时先接手其状态，再重新排入时间轮
+                bool resharded = m_shard && m_shard->tick(now);
+                if (resharded) {
+                    std::cout << "分片成员变化，当前成员: " << describeMembers() << std::endl;
+                    adoptForeignState();
+                }
 
-        // 定期检查所有仓库更新
-        void startPeriodicCheck(unsigned int intervalMinutes = 10) {
-            bool running = true;
+                // 配置变化、分片变化或每分钟一次，把新订阅（或新归属本进程）的仓库排入时间轮
+                bool added = false;
+                {
+                    std::lock_guard lock(monitor.mutex);
+                    std::swap(added, monitor.resync);
+                }
+                bool changed = m_configService.version() != syncedVersion;
+                if (added || resharded || changed || now - lastSync >= 60) {
+                    syncedVersion = m_configService.version();
+                    lastSync      = now;
+                    std::lock_guard lock(monitor.mutex);
+                    scheduleNewRepositories(*config, monitor.wheel, monitor.scheduled, now);
+                }
 
-            while (running) { // Basic loop, consider gRunning for graceful shutdown
-                ReadConfig currentReadConfig(m_config_path); // Re-read config inside loop
-                auto       repositories = currentReadConfig.getAllRepositories();
+                {
+                    std::lock_guard                              lock(monitor.mutex);
+                    std::vector<std::pair<std::string, int64_t>> postponed;
+                    auto expire = [this, &monitor, &backlog, &postponed, now](std::string&& key) {
+                        // check命令提前检查过的仓库已按更晚的时间重新排入，或已由更早的到期项排入积压
+                        auto it = monitor.scheduled.find(key);
+                        if (it == monitor.scheduled.end() || it->second == kQueued || it->second > now)
+                            return;
+                        // 接手其他进程的状态后下一次检查可能推迟到这一项之后，按状态中的时间重新排入
+                        auto state = m_state.get(key);
+                        if (state && state->nextCheck > now) {
+                            it->second = state->nextCheck;
+                            postponed.emplace_back(std::move(key), state->nextCheck);
+                            return;
+                        }
+                        it->second = kQueued;
+                        backlog.push_back(std::move(key));
+                    };
+                    monitor.wheel.advance(now, expire);
+                    for (auto& [key, deadline] : postponed)
+                        monitor.wheel.schedule(std::move(key), deadline);
+                }
+                // 合并窗口结束的卡片优先进入模板与截图阶段
+                monitor.coalescer.setWindow(config->getCoalesceWindow());
+                while (monitor.coalescer.size() > 0 && pipeline.tryAdmit()) {
+                    auto card = monitor.coalescer.takeDue(now);
+                    if (!card) {
+                        pipeline.finish();
+                        break;
+                    }
+                    dispatchCard(monitor, std::move(*card));
+                }
 
-                for (auto const& repo_json : repositories) { // Renamed repo to repo_json
-                    std::string owner    = repo_json["owner"].get<std::string>();
-                    std::string repoName = repo_json["repo"].get<std::string>();
-                    // std::string branch = repo_json.contains("branch") ?
-                    // repo_json["branch"].get<std::string>() : "main"; std::string description =
-                    // repo_json.contains("description") ? repo_json["description"].get<std::string>() :
-                    // ""; std::string lastUpdate = repo_json.contains("lastsha_date") ?
-                    // repo_json["lastsha_date"].get<std::string>() : "";
+                // check命令请求的仓库排在到期的仓库之前；在途检查已满时，到期的仓库留在积压中稍后再试
+                admitChecks(monitor, monitor.urgent, true);
+                admitChecks(monitor, backlog, false);
+                bool unsentChanged = false;
+                {
+                    std::lock_guard lock(monitor.mutex);
+                    monitor.backlogSize = backlog.size();
+                    unsentChanged       = monitor.unsentChanged;
+                }
 
-                    std::cout << "检查仓库 " << owner << "/" << repoName << " 的更新..." << std::endl;
-                    CommitMap newCommitsMap = checkRepositoryUpdates(owner, repoName); // Renamed
+                // 尚未生成的卡片有变化时写入检查队列，进程崩溃后也不会丢失
+                if (unsentChanged) checkpoint(monitor, backlog);
+                m_state.sync();
+                // 停止请求与控制请求会立即唤醒等待
+                std::unique_lock lock(monitor.wakeMutex);
+                monitor.wake.wait_for(lock, stop,
+                                      backlog.empty() ? std::chrono::milliseconds(1000)
+                                                      : std::chrono::milliseconds(100),
+                                      [&monitor]() { return monitor.woken; });
+                monitor.woken = false;
+            }
 
-                    if (newCommitsMap.empty()) {
-                        std::cout << "仓库 " << owner << "/" << repoName << " 没有新的commits。"
-                                  << std::endl;
-                    } else {
-                        std::cout << "仓库 " << owner << "/" << repoName << " 有 " << newCommitsMap.size()
-                                  << " 个新的commits：" << std::endl;
-                        printCommits(newCommitsMap);
-                        // Screenshot generation is now handled within checkRepositoryUpdates
-                    }
-                }
+            // 不再接受控制请求，等待结果的请求立即返回
+            {
+                std::lock_guard lock(monitor.mutex);
+                monitor.stopping = true;
+                for (auto& [key, waiting] : monitor.waiters)
+                    for (auto& waiter : waiting) waiter.set_value(controlError("监控正在停止"));
+                monitor.waiters.clear();
+            }
+            server.stop();
 
-                std::cout << "等待 " << intervalMinutes << " 分钟后再次检查..." << std::endl;
-                std::this_thread::sleep_for(std::chrono::minutes(intervalMinutes));
+            // 合并中的卡片不再等待窗口结束
+            for (auto& card : monitor.coalescer.takeAll()) {
+                pipeline.admit();
+                dispatchCard(monitor, std::move(card));
             }
+
+            // 不再接收新的检查，在期限内等待在途的检查与截图完成，超时则放弃尚未开始的任务
+            auto timeout = config->getDrainTimeout();
+            std::cout << "正在停止监控，最多等待 " << timeout.count() << " 秒完成进行中的检查..." << std::endl;
+            bool   drained = pipeline.drain(std::chrono::steady_clock::now() + timeout);
+            size_t dropped = pipeline.shutdown(!drained);
+            if (dropped > 0) std::cout << "已放弃 " << dropped << " 个尚未开始的任务" << std::endl;
+
+            // 已开始但未完成解析的检查、check命令请求与积压中的仓库，以及没来得及生成或截图被放弃的卡片留待下次启动；
+            // 其余仓库的到期时间已记录在状态中
+            auto [repos, cards] = checkpoint(monitor, backlog);
+            m_state.sync();
+            if (m_shard) m_shard->release();
+            std::cout << "监控已停止";
+            if (repos > 0) std::cout << "，" << repos << " 个仓库将在下次启动时优先检查";
+            if (cards > 0) std::cout << "，" << cards << " 张未生成的卡片将在下次启动时生成";
+            std::cout << std::endl;
         }
 
-        // 获取特定SHA的commit信息
-        std::vector<std::string> getCommitInfoBySha(CommitMap const&   commitMap,
-                                                    std::string const& sha) const {
-            auto it = commitMap.find(sha);
-            if (it != commitMap.end()) return it->second;
-            return {};
+        // 获取特定SHA的commit信息，不存在时返回nullptr
+        CommitRecord const* getCommitBySha(CommitBatch const& commits, std::string const& sha) const {
+            return commits.find(sha);
         }
 
-        // 获取所有SHA
-        std::vector<std::string> getAllShas(CommitMap const& commitMap) const {
+        // 获取所有SHA（最新在前）
+        std::vector<std::string> getAllShas(CommitBatch const& commits) const {
             std::vector<std::string> shas;
-            shas.reserve(commitMap.size());
-            for (auto const& pair : commitMap) shas.push_back(pair.first);
+            shas.reserve(commits.size());
+            for (auto const& commit : commits) shas.emplace_back(commit.sha);
             return shas;
         }
 
         // 打印commits信息 - made public static
-        void static printCommits(CommitMap const& commitMap) {
-            for (auto const& [sha, info] : commitMap) {
-                std::cout << "SHA: " << sha << std::endl;
-                std::cout << "日期: " << info[0] << std::endl;
-                std::cout << "作者: " << info[1] << std::endl;
-                std::cout << "仓库: " << info[2] << std::endl;
-                std::cout << "链接: " << info[3] << std::endl;
-                std::cout << "消息: " << info[4].substr(0, 50) << (info[4].length() > 50 ? "..." : "")
-                          << std::endl;
-                if (info.size() > 5 && !info[5].empty()) std::cout << "头像: " << info[5] << std::endl;
+        void static printCommits(CommitBatch const& commits) {
+            for (auto const& commit : commits) {
+                std::cout << "SHA: " << commit.sha << std::endl;
+                std::cout << "日期: " << commit.date << std::endl;
+                std::cout << "作者: " << commit.author << std::endl;
+                std::cout << "仓库: " << commit.repo << std::endl;
+                std::cout << "链接: " << commit.url << std::endl;
+                std::cout << "消息: " << commit.message.substr(0, 50)
+                          << (commit.message.length() > 50 ? "..." : "") << std::endl;
+                if (!commit.avatarUrl.empty()) std::cout << "头像: " << commit.avatarUrl << std::endl;
                 std::cout << "----------------------------" << std::endl;
             }
         }
 
         // 测试截图生成功能
         bool testScreenshot() {
-            CommitMap testCommits;
-            testCommits["abcdef1234567890"] = {
-                "2025-05-30T12:00:00Z",
-                "TestAuthor1",
-                "TestOwner/TestRepo",
-                "https://github.com/TestOwner/TestRepo/commit/abcdef1234567890",
-                "这是第一个测试提交: 新增炫酷功能!",
-                "https://avatars.githubusercontent.com/u/1?v=4" // Example Avatar
-            };
-            testCommits["fedcba0987654321"] = {
-                "2025-05-29T10:30:00Z",
-                "TestAuthor2",
-                "TestOwner/TestRepo",
-                "https://github.com/TestOwner/TestRepo/commit/fedcba0987654321",
-                "这是第二个测试提交: 修复了一个重要的BUG。",
-                "https://avatars.githubusercontent.com/u/2?v=4" // Example Avatar
-            };
-            testCommits["12345fedcba09876"] = {
-                "2025-05-28T08:15:00Z",
-                "TestAuthor1",
-                "TestOwner/TestRepo",
-                "https://github.com/TestOwner/TestRepo/commit/12345fedcba09876",
-                "这是第三个测试提交: 文档更新和一些小的重构。",
-                "https://avatars.githubusercontent.com/u/1?v=4"};
+            CommitBatch testCommits(std::vector<CommitRecord>{
+                {"abcdef1234567890", "2025-05-30T12:00:00Z", "TestAuthor1", "TestOwner/TestRepo",
+                 "https://github.com/TestOwner/TestRepo/commit/abcdef1234567890",
+                 "这是第一个测试提交: 新增炫酷功能!",
+                 "https://avatars.githubusercontent.com/u/1?v=4"}, // Example Avatar
+                {"fedcba0987654321", "2025-05-29T10:30:00Z", "TestAuthor2", "TestOwner/TestRepo",
+                 "https://github.com/TestOwner/TestRepo/commit/fedcba0987654321",
+                 "这是第二个测试提交: 修复了一个重要的BUG。",
+                 "https://avatars.githubusercontent.com/u/2?v=4"}, // Example Avatar
+                {"12345fedcba09876", "2025-05-28T08:15:00Z", "TestAuthor1", "TestOwner/TestRepo",
+                 "https://github.com/TestOwner/TestRepo/commit/12345fedcba09876",
+                 "这是第三个测试提交: 文档更新和一些小的重构。",
+                 "https://avatars.githubusercontent.com/u/1?v=4"}
+            });
+            // 测试数据不对应真实提交，预先填入统计，避免请求GitHub
+            m_commitStats.put("abcdef1234567890", {120, 8, 5});
+            m_commitStats.put("fedcba0987654321", {3, 1, 1});
+            m_commitStats.put("12345fedcba09876", {42, 57, 9});
             std::cout << "正在测试截图生成功能..." << std::endl;
             // Provide dummy values for branch, description, lastUpdate for testing
-            generateCommitScreenshot("TestOwner", "TestRepo", "main",
-                                     "这是一个用于测试截图功能的示例仓库描述。", "2025-05-30",
-                                     testCommits);
+            generateCommitScreenshot({"TestOwner", "TestRepo", "main",
+                                      "这是一个用于测试截图功能的示例仓库描述。", "2025-05-30",
+                                      testCommits});
             std::cout << "测试截图生成完成！请检查 " << m_output_dir << "/TestOwner_TestRepo.png 文件。"
                       << std::endl;
             return true;
         }
 
     private:
-        std::string m_config_path;
-        std::string m_style_dir;
-        std::string m_output_dir;
-        ReadConfig  m_readConfig;
-        GitHubAPI   m_githubAPI;
+        // 一次检查发现的新提交及生成卡片所需的仓库信息
+        struct CardJob {
+            std::string owner;
+            std::string repo;
+            std::string branch;
+            std::string description;
+            std::string lastUpdate;
+            CommitBatch commits;
 
-        // 从commit JSON数组解析commit信息
-        CommitMap parseCommits(nlohmann::json const& jsonArray) const {
-            CommitMap commitMap;
-            if (!jsonArray.is_array()) return commitMap;
+            // 保存在检查队列中的格式
+            nlohmann::json toJson() const {
+                return {
+                    {      "owner",             owner},
+                    {       "repo",              repo},
+                    {     "branch",            branch},
+                    {"description",       description},
+                    { "lastUpdate",        lastUpdate},
+                    {    "commits", commits.toJson()}
+                };
+            }
 
-            for (auto const& commitJson : jsonArray) {
-                if (!commitJson.is_object()) continue; // Skip non-object items
+            CardJob static fromJson(nlohmann::json const& json) {
+                CardJob card;
+                if (!json.is_object()) return card;
+                card.owner       = json.value("owner", "");
+                card.repo        = json.value("repo", "");
+                card.branch      = json.value("branch", "main");
+                card.description = json.value("description", "");
+                card.lastUpdate  = json.value("lastUpdate", "");
+                if (auto commits = json.find("commits"); commits != json.end())
+                    card.commits = CommitBatch::fromJson(*commits);
+                if (card.owner.empty() || card.repo.empty()) card.commits = CommitBatch();
+                return card;
+            }
+        };
 
-                std::string sha  = commitJson.value("sha", "N/A");
-                std::string date = "N/A";
-                if (commitJson.contains("commit") && commitJson["commit"].is_object()
-                    && commitJson["commit"].contains("committer")
-                    && commitJson["commit"]["committer"].is_object()
-                    && commitJson["commit"]["committer"].contains("date")) {
-                    date = commitJson["commit"]["committer"].value("date", "N/A");
-                }
+        // 模板已渲染、等待截图的卡片
+        struct RenderedCard {
+            std::string             owner;
+            std::string             repo;
+            std::string             html;
+            std::string             basePath;
+            std::vector<OutputSpec> specs;
+        };
+
+        static constexpr int64_t kQueued = -1; // 仓库在积压中或正在检查，时间轮中没有负责它的到期项
 
-                std::string authorLogin = "N/A";
-                std::string avatarUrl   = ""; // Default to empty
-                if (commitJson.contains("author") && commitJson["author"].is_object()) {
-                    authorLogin = commitJson["author"].value("login", "N/A");
-                    avatarUrl   = commitJson["author"].value("avatar_url", "");
+        // 监控期间各阶段共享的调度状态
+        struct Monitor {
+            TimerWheel<std::string> wheel;
+            // 在时间轮中、积压中或正在检查的仓库 -> 负责它的到期项的时间，不在时间轮中时为kQueued
+            std::unordered_map<std::string, int64_t> scheduled;
+            std::map<std::string, uint64_t>          checking; // 已进入流水线、尚未完成解析的仓库 -> 准入序号
+            std::mutex                               mutex;    // 保护wheel、scheduled与checking
+            CheckPipeline&                           pipeline;
+            int64_t                                  fallback;
+            CardCoalescer<CardJob>                   coalescer{}; // 合并窗口中等待生成的卡片
+            int64_t                                  started  = StateJournal::now();
+            uint64_t                                 admitted = 0; // 最近一次准入的序号
+
+            // 已记录为最新、卡片还没生成的提交（受mutex保护），每个仓库合并为一条；
+            // 停止时与检查队列一起保存，运行中有变化时也会保存，下次启动时重新生成
+            std::map<std::string, CardJob> unsent{};
+            bool                           unsentChanged = false;
+
+            // 控制请求（均受mutex保护）
+            using Waiters = std::map<std::string, std::vector<std::promise<nlohmann::json>>>;
+            std::deque<std::string> urgent{};            // check命令请求立即检查的仓库
+            Waiters                 waiters{};           // 等待检查结果的check请求
+            size_t                  backlogSize = 0;     // 上一轮结束时积压的仓库数
+            bool                    resync      = false; // add命令添加了仓库，需要排入时间轮
+            bool                    stopping    = false;
+
+            // 控制请求到达时提前唤醒定时线程
+            std::mutex                  wakeMutex{};
+            std::condition_variable_any wake{};
+            bool                        woken = false;
+        };
+
+        void static reportCommits(std::string const& owner, std::string const& repoName,
+                                  CommitBatch const& commits) {
+            if (commits.empty()) {
+                std::cout << "仓库 " << owner << "/" << repoName << " 没有新的commits。" << std::endl;
+            } else {
+                std::cout << "仓库 " << owner << "/" << repoName << " 有 " << commits.size()
+                          << " 个新的commits：" << std::endl;
+                printCommits(commits);
+            }
+        }
+
+        // 把尚未排入时间轮的仓库加入：沿用状态中的下一次检查时间，已过期或从未检查的
+        // 在最短间隔内随机分散，避免启动时所有仓库同时请求
+        void scheduleNewRepositories(ReadConfig const& config, TimerWheel<std::string>& wheel,
+                                     std::unordered_map<std::string, int64_t>& scheduled, int64_t now) {
+            PollBounds defaults = config.getPollBounds();
+            size_t     added    = 0;
+
+            auto add = [&](std::string key) {
+                if (scheduled.count(key) || (m_shard && !m_shard->owns(key))) return;
+                auto    state    = m_state.get(key);
+                int64_t deadline = state && state->nextCheck > now ? state->nextCheck
+                                                                   : now + jitter(defaults.minSeconds);
+                scheduled.emplace(key, deadline);
+                wheel.schedule(std::move(key), deadline);
+                ++added;
+            };
+
+            for (auto const& entry : config.getAllRepositories()) add(entry.fullName());
+            if (m_store.refresh())
+                for (auto& key : m_store.keys()) add(std::move(key));
+            if (added > 0) std::cout << "已安排 " << added << " 个仓库的检查" << std::endl;
+        }
+
+        // 抓取阶段（I/O线程）：读取仓库详情并请求最新提交，解析交给CPU线程
+        void fetchStage(Monitor& monitor, std::string const& key) {
+            size_t      slash    = key.find('/');
+            std::string owner    = key.substr(0, slash);
+            std::string repoName = key.substr(slash + 1);
+            auto        config   = m_configService.snapshot();
+            // 只有到期的仓库才读取详情（分片存储中会加载所在分片）
+            auto entry = findRepository(*config, owner, repoName);
+            // 已取消订阅，或分片变化后归属其他工作进程
+            if (!entry || (m_shard && !m_shard->owns(key))) {
+                {
+                    std::lock_guard lock(monitor.mutex);
+                    monitor.scheduled.erase(key);
+                    monitor.checking.erase(key);
                 }
+                answerWaiters(monitor, key, controlError("仓库 " + key + " 已不由本进程检查"));
+                monitor.pipeline.finish();
+                return;
+            }
 
-                std::string htmlUrl     = commitJson.value("html_url", "");
-                std::string repoFromUrl = extractRepoFromUrl(htmlUrl);
+            std::cout << "检查仓库 " << key << " 的更新..." << std::endl;
+            // 只取回响应正文，JSON在CPU线程上解析到检查内存区中
+            PollBounds  bounds = AdaptivePolling::boundsFor(&*entry, config->getPollBounds());
+            std::string body   = m_githubAPI.getCommitsText(owner, repoName, 10).value_or("");
+            monitor.pipeline.cpu([this, &monitor, key, bounds, body = std::move(body)]() {
+                parseStage(monitor, key, bounds, body);
+            });
+        }
 
-                std::string message = "N/A";
-                if (commitJson.contains("commit") && commitJson["commit"].is_object())
-                    message = commitJson["commit"].value("message", "N/A");
+        // 解析阶段（CPU线程）：找出新提交并安排下一次检查，有新提交时继续生成卡片
+        void parseStage(Monitor& monitor, std::string const& key, PollBounds bounds,
+                        std::string const& body) {
+            size_t  slash = key.find('/');
+            CardJob card  = selectNewCommits(key.substr(0, slash), key.substr(slash + 1), body);
+            if (!card.commits.empty()) holdCard(monitor, card);
+            reportCommits(card.owner, card.repo, card.commits);
+            int64_t next = scheduleNext(key, card.commits, bounds, monitor.fallback);
+            {
+                std::lock_guard lock(monitor.mutex);
+                monitor.wheel.schedule(key, next);
+                monitor.scheduled[key] = next;
+                monitor.checking.erase(key);
+            }
+            nlohmann::json result = {
+                {     "ok",         true},
+                {"commits", card.commits.toJson()}
+            };
+            // check命令请求的仓库不等合并窗口结束，连同已合并的提交立即生成卡片
+            bool requested = answerWaiters(monitor, key, result);
+            if (auto pending = requested ? monitor.coalescer.take(key) : std::nullopt) {
+                mergeCards(*pending, std::move(card));
+                card = std::move(*pending);
+            }
+            if (card.commits.empty()) {
+                monitor.pipeline.finish();
+                return;
+            }
+            // 开启合并时先放入待发送的卡片，仓库安静下来（或等待超过最长延迟）后再一起生成
+            if (!requested && monitor.coalescer.window().enabled()) {
+                int64_t now    = StateJournal::now();
+                bool    merged = monitor.coalescer.add(key, std::move(card), now, mergeCards);
+                std::cout << "仓库 " << key << " 的新提交"
+                          << (merged ? "已合并到待发送的卡片" : "将在合并窗口结束后生成卡片") << std::endl;
+                monitor.pipeline.finish();
+                return;
+            }
+            composeStage(monitor, std::move(card));
+        }
 
-                commitMap[sha] = {date, authorLogin, repoFromUrl, htmlUrl, message, avatarUrl};
+        // 已占用准入名额的卡片：模板需要变更统计时先回到I/O线程请求，再回到CPU线程生成页面
+        void composeStage(Monitor& monitor, CardJob card) {
+            if (needsCommitStats()) {
+                monitor.pipeline.io([this, &monitor, card = std::move(card)]() {
+                    fetchCommitStats(card.owner, card.repo, card.commits);
+                    monitor.pipeline.cpu([this, &monitor, card]() { templateStage(monitor, card); });
+                });
+                return;
             }
-            return commitMap;
+            templateStage(monitor, card);
         }
 
-        // 从URL中提取仓库名
-        std::string extractRepoFromUrl(std::string const& url) const {
-            std::string owner_local; // Renamed
-            std::string repo_local;  // Renamed
+        // 合并窗口结束的卡片在CPU线程上继续生成
+        void dispatchCard(Monitor& monitor, CardJob card) {
+            std::cout << "生成仓库 " << card.owner << "/" << card.repo << " 的合并卡片（" << card.commits.size()
+                      << " 个提交）" << std::endl;
+            monitor.pipeline.cpu([this, &monitor, card = std::move(card)]() mutable {
+                composeStage(monitor, std::move(card));
+            });
+        }
 
-            size_t start = url.find("github.com/");
-            if (start != std::string::npos) {
-                start += 11;
+        // 同一仓库后发现的提交排在待发送卡片的提交之前，仓库信息以最新的为准
+        void static mergeCards(CardJob& pending, CardJob&& incoming) {
+            incoming.commits.append(pending.commits);
+            pending.commits     = std::move(incoming.commits);
+            pending.branch      = std::move(incoming.branch);
+            pending.description = std::move(incoming.description);
+        }
+
+        // 模板阶段（CPU线程）：生成页面后归还准入名额，截图在截图线程上排队
+        void templateStage(Monitor& monitor, CardJob const& card) {
+            RenderedCard rendered = buildCard(card);
+            monitor.pipeline.finish();
+            // 停止时超过期限被放弃或截图失败的卡片，其中的提交留在未生成的卡片中，下次启动时重新生成
+            monitor.pipeline.render([this, &monitor, key = StateJournal::key(card.owner, card.repo),
+                                     shas = getAllShas(card.commits), rendered = std::move(rendered)]() {
+                if (renderCard(rendered)) releaseCard(monitor, key, shas);
+            });
+        }
 
-                size_t ownerEnd = url.find("/", start);
-                if (ownerEnd != std::string::npos) {
-                    owner_local = url.substr(start, ownerEnd - start);
+        // 记录尚未生成卡片的新提交，同一仓库的多张卡片按mergeCards的顺序合并
+        void static holdCard(Monitor& monitor, CardJob const& card) {
+            std::lock_guard lock(monitor.mutex);
+            auto [it, fresh] = monitor.unsent.try_emplace(StateJournal::key(card.owner, card.repo), card);
+            if (!fresh) mergeCards(it->second, CardJob(card));
+            monitor.unsentChanged = true;
+        }
+
+        // 卡片已生成，不再需要在下次启动时重新生成其中的提交
+        void static releaseCard(Monitor& monitor, std::string const& key,
+                                std::vector<std::string> const& shas) {
+            std::lock_guard lock(monitor.mutex);
+            auto            it = monitor.unsent.find(key);
+            if (it == monitor.unsent.end()) return;
+            std::unordered_set<std::string_view> done(shas.begin(), shas.end());
+            it->second.commits.retain(
+                [&done](CommitRecord const& commit) { return !done.contains(commit.sha); });
+            if (it->second.commits.empty()) monitor.unsent.erase(it);
+            monitor.unsentChanged = true;
+        }
 
-                    size_t repoStart = ownerEnd + 1;
-                    size_t repoEnd   = url.find("/", repoStart);
-                    if (repoEnd != std::string::npos)
-                        repo_local = url.substr(repoStart, repoEnd - repoStart);
+        // 把未完成的检查与未生成的卡片写入检查队列，返回保存的仓库数与卡片数；
+        // 仓库依次为按准入顺序的在途检查、check命令请求的仓库与积压中的仓库
+        std::pair<size_t, size_t> checkpoint(Monitor& monitor, std::deque<std::string> const& backlog) {
+            std::vector<std::string> repos;
+            nlohmann::json           cards = nlohmann::json::array();
+            {
+                std::lock_guard lock(monitor.mutex);
+                std::vector<std::pair<uint64_t, std::string>> inFlight;
+                for (auto const& [key, order] : monitor.checking) inFlight.emplace_back(order, key);
+                std::sort(inFlight.begin(), inFlight.end());
+                for (auto& [order, key] : inFlight) repos.push_back(std::move(key));
+                repos.insert(repos.end(), monitor.urgent.begin(), monitor.urgent.end());
+                for (auto const& [key, card] : monitor.unsent) cards.push_back(card.toJson());
+                monitor.unsentChanged = false;
+            }
+            repos.insert(repos.end(), backlog.begin(), backlog.end());
+            std::unordered_set<std::string> seen;
+            std::erase_if(repos, [&seen](std::string const& key) { return !seen.insert(key).second; });
+            m_state.saveQueue(repos, cards);
+            return {repos.size(), cards.size()};
+        }
+
+        // 按队列顺序为仓库申请准入名额并进入抓取阶段，已在检查中的仓库不重复检查
+        void admitChecks(Monitor& monitor, std::deque<std::string>& queue, bool shared) {
+            while (true) {
+                std::string key;
+                {
+                    std::unique_lock lock(monitor.mutex, std::defer_lock);
+                    if (shared) lock.lock(); // urgent由控制请求线程写入
+                    if (queue.empty() || !monitor.pipeline.tryAdmit()) return;
+                    key = std::move(queue.front());
+                    queue.pop_front();
+                    if (!shared) lock.lock();
+                    if (!monitor.checking.try_emplace(key, ++monitor.admitted).second) {
+                        monitor.pipeline.finish();
+                        continue;
+                    }
                 }
+                monitor.pipeline.io([this, &monitor, key]() { fetchStage(monitor, key); });
             }
+        }
 
-            if (!owner_local.empty() && !repo_local.empty()) return owner_local + "/" + repo_local;
-            return "";
+        // 控制请求：在连接线程上执行，check等待检查流水线给出结果
+        nlohmann::json handleControl(Monitor& monitor, nlohmann::json const& request) {
+            std::string command = request.value("command", "");
+            std::string owner   = request.value("owner", "");
+            std::string repo    = request.value("repo", "");
+            if (command == "status") return controlStatus(monitor);
+            if (command == "list") return controlList();
+            if (command == "check") return controlCheck(monitor, owner, repo);
+            if (command == "add") {
+                return controlAdd(monitor, owner, repo, request.value("branch", "main"));
+            }
+            return controlError("未知的控制命令: " + command);
         }
 
-        // 更新配置文件中的lastsha
-        void updateLastSha(std::string const& owner, std::string const& repo, std::string const& sha) {
-            nlohmann::json config_json; // Renamed
-            std::ifstream  config_in(m_config_path);
-            if (config_in.is_open()) {
-                config_in >> config_json;
-                config_in.close();
+        nlohmann::json controlStatus(Monitor& monitor) {
+            nlohmann::json status = {
+                {        "ok",                                  true},
+                {    "worker",                           m_worker_id},
+                {    "uptime", StateJournal::now() - monitor.started},
+                {  "inFlight",           monitor.pipeline.inFlight()},
+                {    "render",      monitor.pipeline.renderBacklog()},
+                {"coalescing",              monitor.coalescer.size()}
+            };
+            if (m_shard) status["members"] = m_shard->members();
+            status["interned"]      = StringInterner::global().size();
+            status["internedBytes"] = StringInterner::global().bytes();
+            std::lock_guard lock(monitor.mutex);
+            status["scheduled"] = monitor.scheduled.size();
+            status["checking"]  = monitor.checking.size();
+            status["backlog"]   = monitor.backlogSize + monitor.urgent.size();
+            return status;
+        }
 
-                Set_config setConfig(config_json, m_config_path);
-                setConfig.setLastSha(owner, repo, sha);
+        // 本进程负责的仓库及其状态；状态取自内存，比状态文件更新
+        nlohmann::json controlList() {
+            auto           config = m_configService.snapshot();
+            nlohmann::json repos  = nlohmann::json::array();
+            auto           add    = [&](RepositoryEntry const& entry) {
+                std::string key = entry.fullName();
+                if (m_shard && !m_shard->owns(key)) return;
+                auto        state   = m_state.get(key);
+                std::string lastSha = state ? state->lastSha : "";
+                repos.push_back({
+                    {   "name",                                             key},
+                    { "branch",                                    entry.branch},
+                    {"lastSha", lastSha.empty() ? entry.legacyLastSha : lastSha},
+                    {   "next",                    state ? state->nextCheck : 0}
+                });
+            };
+            for (auto const& entry : config->getAllRepositories()) add(entry);
+            m_store.forEach([&](RepositoryEntry const& entry) {
+                if (!config->repositories().contains(entry.owner, entry.repo)) add(entry);
+            });
+            return {
+                {    "ok",        true},
+                {"worker", m_worker_id},
+                { "repos",       repos}
+            };
+        }
 
-                std::cout << "已更新仓库 " << owner << "/" << repo << " 的最新SHA: " << sha << std::endl;
-            } else {
-                std::cerr << "无法打开配置文件进行SHA更新: " << m_config_path << std::endl;
+        // 请求立即检查一个仓库并等待结果；未订阅或不归本进程的仓库由调用方在本地检查
+        nlohmann::json controlCheck(Monitor& monitor, std::string const& owner, std::string const& repo) {
+            std::string key    = StateJournal::key(owner, repo);
+            auto        config = m_configService.snapshot();
+            if (!findRepository(*config, owner, repo) || (m_shard && !m_shard->owns(key))) {
+                nlohmann::json local = controlError("仓库 " + key + " 不由本进程检查");
+                local["local"]       = true;
+                return local;
             }
+
+            std::future<nlohmann::json> result;
+            {
+                std::lock_guard lock(monitor.mutex);
+                if (monitor.stopping) return controlError("监控正在停止");
+                auto& waiting = monitor.waiters[key];
+                waiting.emplace_back();
+                result = waiting.back().get_future();
+                // 正在检查的仓库等待这次检查的结果即可
+                if (waiting.size() == 1 && !monitor.checking.contains(key)) {
+                    monitor.urgent.push_back(key);
+                    monitor.scheduled.try_emplace(key, kQueued);
+                }
+            }
+            wakeTicker(monitor);
+            if (result.wait_for(kControlCheckTimeout) != std::future_status::ready)
+                return controlError("等待仓库 " + key + " 的检查结果超时");
+            return result.get();
+        }
+
+        nlohmann::json controlAdd(Monitor& monitor, std::string const& owner, std::string const& repo,
+                                  std::string const& branch) {
+            if (owner.empty() || repo.empty()) return controlError("缺少owner或repo");
+            auto config = m_configService.snapshot();
+            if (findRepository(*config, owner, repo)) {
+                return {
+                    {   "ok",  true},
+                    {"added", false}
+                };
+            }
+            // 获取最新提交失败时仓库仍会加入订阅，只是没有初始SHA
+            addRepository(owner, repo, branch);
+            {
+                std::lock_guard lock(monitor.mutex);
+                monitor.resync = true;
+            }
+            wakeTicker(monitor);
+            return {
+                {     "ok",                                                 true},
+                {  "added",                                                 true},
+                {"lastSha", m_state.lastSha(StateJournal::key(owner, repo))}
+            };
+        }
+
+        // 把检查结果交给等待中的check请求，返回是否有请求在等待
+        bool static answerWaiters(Monitor& monitor, std::string const& key,
+                                  nlohmann::json const& result) {
+            std::vector<std::promise<nlohmann::json>> waiting;
+            {
+                std::lock_guard lock(monitor.mutex);
+                auto            it = monitor.waiters.find(key);
+                if (it == monitor.waiters.end()) return false;
+                waiting = std::move(it->second);
+                monitor.waiters.erase(it);
+            }
+            for (auto& waiter : waiting) waiter.set_value(result);
+            return true;
+        }
+
+        void static wakeTicker(Monitor& monitor) {
+            {
+                std::lock_guard lock(monitor.wakeMutex);
+                monitor.woken = true;
+            }
+            monitor.wake.notify_all();
+        }
+
+        nlohmann::json static controlError(std::string const& message) {
+            return {
+                {   "ok",   false},
+                {"error", message}
+            };
+        }
+
+        // 接手仓库时采用其他状态目录中更新的记录，不会重复推送对方已经处理过的提交
+        void adoptForeignState() {
+            size_t adopted = 0;
+            for (auto const& [key, state] : StateJournal::collect(m_config_path, m_state.directory())) {
+                if (m_shard && !m_shard->owns(key)) continue;
+                auto own = m_state.get(key);
+                if (own && StateJournal::freshness(*own) >= StateJournal::freshness(state)) continue;
+                m_state.put(key, state);
+                ++adopted;
+            }
+            if (adopted > 0) std::cout << "已接手 " << adopted << " 个仓库的状态" << std::endl;
+        }
+
+        std::string describeMembers() const {
+            std::string text;
+            for (auto const& member : m_shard->members()) text += (text.empty() ? "" : ", ") + member;
+            return text.empty() ? "无" : text;
+        }
+
+        // [0, range) 内的随机秒数
+        int64_t static jitter(int64_t range) {
+            if (range <= 1) return 0;
+            thread_local std::mt19937_64 rng{std::random_device{}()};
+            return std::uniform_int_distribution<int64_t>(0, range - 1)(rng);
+        }
+
+        // 根据本次检查结果更新平均提交间隔，并记录下一次检查时间
+        int64_t scheduleNext(std::string const& key, CommitBatch const& commits, PollBounds bounds,
+                             int64_t fallback) {
+            std::vector<int64_t> times;
+            times.reserve(commits.size());
+            for (auto const& commit : commits)
+                times.push_back(HistoryStore::parseTime(std::string(commit.date)));
+
+            int64_t next = 0;
+            m_state.update(key, [&](RepoState& state) {
+                int64_t now = StateJournal::now();
+                AdaptivePolling::observe(state, times);
+                bool    changed  = !commits.empty();
+                int64_t interval = AdaptivePolling::interval(state, bounds, now, changed, fallback);
+                // 加上最多10%的抖动，同时检查的仓库下一轮错开
+                state.nextCheck = now + interval + jitter(interval / 10 + 1);
+                next            = state.nextCheck;
+            });
+            return next;
+        }
+
+        // 解析抓取结果，与记录的SHA比较找出新提交，并更新状态与本地历史
+        // 响应的JSON与解析用的临时数组都分配在本次检查的内存区中，返回前一次释放；卡片只带走拷贝出的提交
+        CardJob selectNewCommits(std::string const& owner, std::string const& repo,
+                                 std::string_view body) {
+            CardJob card;
+            card.owner        = owner;
+            card.repo         = repo;
+            auto config       = m_configService.snapshot();
+            auto entry        = findRepository(*config, owner, repo);
+            card.branch       = entry ? entry->branch : "main";
+            card.description  = entry ? entry->description : "";
+
+            CheckArena arena;
+            ArenaJson  commits_json;
+            try {
+                if (!body.empty()) commits_json = ArenaJson::parse(body);
+            } catch (nlohmann::json::parse_error const& e) {
+                std::cerr << "JSON parse error: " << e.what() << std::endl;
+            }
+            if (commits_json.empty() || !commits_json.is_array()) {
+                std::cerr << "获取仓库 " << owner << "/" << repo << " 的commit失败！" << std::endl;
+                return card;
+            }
+            std::string key     = StateJournal::key(owner, repo);
+            auto        state   = m_state.get(key);
+            std::string lastSha = state ? state->lastSha : "";
+            m_state.markChecked(key);
+
+            // 解析commit信息，保持API返回的顺序（最新在前）
+            CommitBatch commits = parseCommits(commits_json);
+            if (commits.empty()) return card;
+
+            // 记录的SHA之前的都是新提交；没有记录的SHA，或记录的SHA不在本次获取的范围内时，全部视为新提交
+            std::string latestSha(commits[0].sha);
+            for (size_t i = 0; i < commits.size(); ++i) {
+                if (commits[i].sha != lastSha) continue;
+                commits.truncate(i);
+                break;
+            }
+            // 强制推送或改写分支后记录的SHA可能已不在历史中，推送过的提交不再重复推送
+            if (state && !state->seen.empty()) {
+                commits.retain([&seen = state->seen](CommitRecord const& commit) {
+                    auto id = ShaKey::fromHex(commit.sha);
+                    return !id || !seen.contains(*id);
+                });
+            }
+            card.commits = std::move(commits);
+            if (latestSha != lastSha) updateLastSha(owner, repo, latestSha, card.commits);
+            if (card.commits.empty()) return card;
+
+            recordHistory(owner, repo, card.commits);
+            return card;
+        }
+
+        // 仓库详情：先查config.json，再查分片存储
+        std::optional<RepositoryEntry> findRepository(ReadConfig const& config, std::string const& owner,
+                                                      std::string const& repo) {
+            if (auto const* entry = config.repositories().find(owner, repo)) return *entry;
+            return m_store.find(owner, repo);
+        }
+
+        std::string m_config_path;
+        std::string m_style_dir;
+        std::string m_output_dir;
+        std::string m_worker_id;
+        ConfigService     m_configService; // 配置文件变化时自动发布新快照
+        GitHubAPI         m_githubAPI;
+        ScreenshotManager m_screenshotManager; // 跨多次渲染保留背景索引
+        StateJournal      m_state;             // 每个仓库的可变状态，与config.json分开保存
+        SubscriptionStore m_store;             // 可选的分片订阅存储，仓库多时代替config.json中的列表
+        HistoryStore      m_history;           // 已获取提交的本地历史，供history命令查询
+        CommitStatsCache  m_commitStats;       // 按SHA缓存的增删统计
+        std::mutex        m_backgroundMutex;   // 背景索引与预缩放选项由各线程共用
+        std::unique_ptr<ShardCoordinator> m_shard; // 分片模式下的租约与成员信息
+
+        // 只为缓存中没有的提交并发请求详情
+        void fetchCommitStats(std::string const& owner, std::string const& repo,
+                              CommitBatch const& commits) {
+            std::vector<std::string> shas;
+            shas.reserve(commits.size());
+            for (auto const& commit : commits) shas.emplace_back(commit.sha);
+            std::vector<std::string> missing = m_commitStats.missing(shas);
+            if (missing.empty()) return;
+
+            auto details = m_githubAPI.getCommitDetails(owner, repo, missing);
+            for (auto const& [sha, commitJson] : details)
+                m_commitStats.put(sha, CommitStatsCache::parse(commitJson));
+            std::cout << "已获取 " << details.size() << "/" << missing.size() << " 个提交的变更统计" << std::endl;
+        }
+
+        // 从commit JSON数组解析commit信息：各字段先取JSON中字符串的视图，最后一次性拷贝到批次缓冲区
+        CommitBatch parseCommits(ArenaJson const& jsonArray) const {
+            std::pmr::vector<CommitRecord> records(CheckArena::resource());
+            if (!jsonArray.is_array()) return CommitBatch(records);
+            records.reserve(jsonArray.size());
+
+            for (auto const& commitJson : jsonArray) {
+                if (!commitJson.is_object()) continue; // Skip non-object items
+
+                ArenaJson const& commit       = object(commitJson, "commit");
+                ArenaJson const& author       = object(commitJson, "author");
+                ArenaJson const& verification = object(commit, "verification");
+                CommitRecord     record;
+                record.sha       = CommitBatch::text(commitJson, "sha", "N/A");
+                record.date      = CommitBatch::text(object(commit, "committer"), "date", "N/A");
+                record.author    = CommitBatch::text(author, "login", "N/A");
+                record.avatarUrl = CommitBatch::text(author, "avatar_url");
+                record.url       = CommitBatch::text(commitJson, "html_url");
+                record.repo      = extractRepoFromUrl(record.url);
+                record.message   = CommitBatch::text(commit, "message", "N/A");
+                record.verified  = verification.is_object() && verification.value("verified", false);
+                records.push_back(record);
+            }
+            return CommitBatch(records);
+        }
+
+        // 子对象，不存在或不是对象时返回null（不占用任何内存区，可以跨越多次检查共用）
+        ArenaJson const static& object(ArenaJson const& parent, char const* key) {
+            static ArenaJson const empty;
+            auto                   it = parent.find(key);
+            return it != parent.end() && it->is_object() ? *it : empty;
+        }
+
+        // 从URL中提取仓库名（owner/repo），返回url中对应部分的视图
+        std::string_view static extractRepoFromUrl(std::string_view url) {
+            size_t start = url.find("github.com/");
+            if (start == std::string_view::npos) return {};
+            start += 11;
+
+            size_t ownerEnd = url.find('/', start);
+            if (ownerEnd == std::string_view::npos || ownerEnd == start) return {};
+            size_t repoEnd = url.find('/', ownerEnd + 1);
+            if (repoEnd == std::string_view::npos || repoEnd == ownerEnd + 1) return {};
+            return url.substr(start, repoEnd - start);
+        }
+
+        // 在状态日志中记录最新SHA，不再改写config.json
+        // 同时把新提交加入已推送集合；没有新提交（分支被改写为已推送过的提交）时不更新发现时间
+        void updateLastSha(std::string const& owner, std::string const& repo, std::string const& sha,
+                           CommitBatch const& commits) {
+            m_state.update(StateJournal::key(owner, repo), [&](RepoState& state) {
+                state.lastSha = sha;
+                if (!commits.empty()) state.lastUpdated = StateJournal::now();
+                for (auto const& commit : commits)
+                    if (auto id = ShaKey::fromHex(commit.sha)) state.seen.insert(*id);
+            });
+            std::cout << "已更新仓库 " << owner << "/" << repo << " 的最新SHA: " << sha << std::endl;
+        }
+
+        // 把本次发现的提交追加到本地历史
+        void recordHistory(std::string const& owner, std::string const& repo,
+                           CommitBatch const& commits) {
+            std::vector<HistoryRecord> records;
+            records.reserve(commits.size());
+            for (auto const& commit : commits) {
+                HistoryRecord record;
+                record.sha       = commit.sha;
+                record.date      = commit.date;
+                record.author    = commit.author;
+                record.url       = commit.url;
+                record.message   = commit.message;
+                record.avatarUrl = commit.avatarUrl;
+                record.verified  = commit.verified;
+                record.time      = HistoryStore::parseTime(record.date);
+                records.push_back(std::move(record));
+            }
+            m_history.append(StateJournal::key(owner, repo), records);
+        }
+
+        // 旧版本把lastsha写在config.json里，首次运行时导入状态日志
+        void migrateLegacyState() {
+            size_t migrated = 0;
+            auto config = m_configService.snapshot();
+            for (auto const& entry : config->getAllRepositories()) {
+                std::string key = StateJournal::key(entry.owner, entry.repo);
+                if (m_state.seed(key, entry.legacyLastSha)) ++migrated;
+            }
+            if (migrated == 0) return;
+            m_state.sync();
+            std::cout << "已从配置文件迁移 " << migrated << " 个仓库的状态" << std::endl;
         }
 
         // 替换字符串中的所有匹配项 (helper)
@@ -341,16 +1014,31 @@ namespace Yume {
             return str;
         }
 
-        // 生成成commit信息的HTML模板并截图
-        void generateCommitScreenshot(std::string const& owner, std::string const& repo,
-                                      std::string const& branch, std::string const& description,
-                                      std::string const& lastUpdate, CommitMap const& commits) {
+        // 生成成commit信息的HTML模板并截图（在当前线程依次完成各阶段）
+        void generateCommitScreenshot(CardJob const& card) {
+            if (needsCommitStats()) fetchCommitStats(card.owner, card.repo, card.commits);
+            renderCard(buildCard(card));
+        }
+
+        // 模板用到的变量决定需要哪些额外数据；默认主题不需要额外请求
+        bool needsCommitStats() {
+            return CommitDataNeeds::from(m_screenshotManager.themeTemplate()).stats;
+        }
+
+        // 填充主题模板，得到待截图的页面；变更统计需已在缓存中
+        RenderedCard buildCard(CardJob const& card) {
+            std::string const& owner       = card.owner;
+            std::string const& repo        = card.repo;
+            std::string const& description = card.description;
+            std::string const& lastUpdate  = card.lastUpdate;
+            CommitBatch const& commits     = card.commits;
+            auto               config      = m_configService.snapshot(); // 本次渲染使用同一份配置
             std::map<std::string, std::string> variables;
             variables["title"]       = owner + "/" + repo + " GitHub 更新";
             variables["owner"]       = owner;
             variables["repo"]        = repo;
             variables["commitCount"] = std::to_string(commits.size());
-            variables["branch"]      = branch;
+            variables["branch"]      = card.branch;
 
             auto    now     = std::chrono::system_clock::now();
             auto    nowTime = std::chrono::system_clock::to_time_t(now);
@@ -363,18 +1051,25 @@ namespace Yume {
             std::stringstream dateStream;
             dateStream << std::put_time(&tm_buf, "%Y-%m-%d %H:%M:%S");
             variables["currentDate"] = dateStream.str();
-            ScreenshotManager screenshotManager(
-                m_style_dir); // Instance of ScreenshotManager with custom style dir            //
-                              // 根据配置决定是否使用随机背景图片
-            if (m_readConfig.getBackgroundsEnabled()) {
-                std::string bgPath = screenshotManager.getRandomBackground(m_style_dir + "/backgrounds");
+            // 根据配置决定是否使用随机背景图片
+            if (config->getBackgroundsEnabled()) {
+                std::lock_guard      backgroundLock(m_backgroundMutex);
+                BackgroundCatalogue& catalogue =
+                    m_screenshotManager.backgroundCatalogue(m_style_dir + "/backgrounds");
+                catalogue.setMode(BackgroundCatalogue::parseMode(config->getBackgroundMode()));
+                catalogue.setWeights(config->getBackgroundWeights());
+                std::string bgPath = m_screenshotManager.getRandomBackground(m_style_dir + "/backgrounds",
+                                                                             owner + "/" + repo);
                 if (!bgPath.empty()) {
+                    // 优先使用按卡片尺寸预缩放的版本，失败时回退到原图
+                    m_screenshotManager.backgroundVariants().setOptions(
+                        config->getBackgroundScaleOptions());
+                    std::string variant = m_screenshotManager.backgroundVariants().variantFor(bgPath);
                     // screenshot.js needs a URL-friendly path, relative to the HTML file or absolute.
                     // Let's make it relative to Style/ if backgrounds is inside Style/
                     std::filesystem::path p = bgPath;
                     variables["backgroundImage"] =
-                        "backgrounds/"
-                        + p.filename().string(); // Create relative path to backgrounds folder
+                        !variant.empty() ? variant : "backgrounds/" + p.filename().string();
                 } else {
                     variables["backgroundImage"] = ""; // 不使用背景图片
                 }
@@ -388,49 +1083,118 @@ namespace Yume {
             variables["last_update_html_content"] =
                 lastUpdate.empty() ? "" : "<div class=\"stat-item\">最后更新: " + lastUpdate + "</div>";
 
-            std::string commitsHtml_content;                  // Renamed
-            for (auto const& [sha_key, info_vec] : commits) { // Renamed
-                std::string commit_message      = info_vec.size() > 4 ? info_vec[4] : "N/A";
-                std::string commit_sha_short    = sha_key.substr(0, 7);
-                std::string commit_author_login = info_vec.size() > 1 ? info_vec[1] : "N/A";
-                std::string commit_date         = info_vec.size() > 0 ? info_vec[0] : "N/A";
-                std::string commit_html_url     = info_vec.size() > 3 ? info_vec[3] : "#";
-                std::string commit_avatar_url   = info_vec.size() > 5 ? info_vec[5] : "";
-
-                std::string avatar_html;
-                if (!commit_avatar_url.empty()) {
-                    avatar_html = "<img src=\"" + commit_avatar_url + "\" alt=\"" + commit_author_login
-                                + "\" class=\"author-avatar\">";
+            CompiledTemplate const& compiled = m_screenshotManager.themeTemplate();
+            CommitDataNeeds         needs    = CommitDataNeeds::from(compiled);
+
+            bool                                     wantList = compiled.uses("commits_list_html");
+            std::string                              commitsHtml_content;
+            std::vector<CompiledTemplate::Variables> rows;
+            CommitStats                              totals;
+            // 同一作者的转义名称与头像片段只生成一次；作者与头像是驻留的视图，按地址查找
+            // 这些片段只在本次渲染中使用，分配在检查内存区中
+            CheckArena arena;
+            using AuthorKey = std::tuple<char const*, size_t, char const*, size_t>;
+            std::pmr::map<AuthorKey, std::pair<std::pmr::string, std::pmr::string>> authorHtml(
+                CheckArena::resource());
+            for (auto const& commit : commits) {
+                // 短代码转emoji、粗体/代码等轻量markdown，只展示第一行摘要
+                std::string      commit_message    = MessageFormatter::toHtml(commit.message);
+                std::string_view commit_sha_short  = commit.sha.substr(0, 7);
+                std::string_view commit_date       = commit.date;
+                std::string_view commit_html_url   = commit.url.empty() ? "#" : commit.url;
+                std::string_view commit_avatar_url = commit.avatarUrl;
+
+                AuthorKey authorKey{commit.author.data(), commit.author.size(), commit_avatar_url.data(),
+                                    commit_avatar_url.size()};
+                auto [author, fresh] = authorHtml.try_emplace(authorKey);
+                if (fresh) {
+                    author->second.first = MessageFormatter::escape(commit.author);
+                    if (!commit_avatar_url.empty()) {
+                        author->second.second.append("<img src=\"")
+                            .append(commit_avatar_url)
+                            .append("\" alt=\"")
+                            .append(author->second.first)
+                            .append("\" class=\"author-avatar\">");
+                    }
+                }
+                std::string_view commit_author_login = author->second.first;
+                std::string_view avatar_html         = author->second.second;
+
+                if (wantList) {
+                    commitsHtml_content.append("<li class=\"commit-item\">")
+                        .append("<div class=\"commit-message\">")
+                        .append(commit_message)
+                        .append("</div>" "<div class=\"commit-details\">" "<span class=\"commit-sha\">")
+                        .append(commit_sha_short)
+                        .append("</span>" "<span class=\"commit-author\">")
+                        .append(avatar_html)
+                        .append("<span>")
+                        .append(commit_author_login)
+                        .append("</span></span>" "<span class=\"commit-date\">")
+                        .append(commit_date)
+                        // 移除了"在GitHub上查看"链接元素
+                        .append("</span>" "</div>" "</li>");
                 }
 
-                commitsHtml_content +=
-                    "<li class=\"commit-item\">" "<div class=\"commit-message\">" + commit_message
-                    + "</div>" "<div class=\"commit-details\">" "<span class=\"commit-sha\">"
-                    + commit_sha_short + "</span>" "<span class=\"commit-author\">" + avatar_html
-                    + "<span>" + commit_author_login + "</span></span>" "<span class=\"commit-date\">"
-                    + commit_date
-                    + "</span>" "</div>"
-                      // 移除了"在GitHub上查看"链接元素
-                      "</li>";
+                if (!compiled.hasSection("commits")) continue;
+                CompiledTemplate::Variables row;
+                row["sha"]         = commit.sha;
+                row["sha_short"]   = commit_sha_short;
+                row["message"]     = commit_message;
+                row["author"]      = commit_author_login;
+                row["avatar_url"]  = commit_avatar_url;
+                row["avatar_html"] = avatar_html;
+                row["date"]        = commit_date;
+                row["url"]         = commit_html_url;
+                if (needs.verification)
+                    row["verified"] = commit.verified ? "verified" : "";
+                if (needs.coAuthors) {
+                    std::string names;
+                    for (auto const& name : parseCoAuthors(commit.message)) {
+                        if (!names.empty()) names += ", ";
+                        names += MessageFormatter::escape(name);
+                    }
+                    row["coauthors"] = names;
+                }
+                if (needs.stats) {
+                    CommitStats stats = m_commitStats.find(commit.sha).value_or(CommitStats{});
+                    row["additions"]     = std::to_string(stats.additions);
+                    row["deletions"]     = std::to_string(stats.deletions);
+                    row["changed_files"] = std::to_string(stats.changedFiles);
+                    totals.additions += stats.additions;
+                    totals.deletions += stats.deletions;
+                    totals.changedFiles += stats.changedFiles;
+                }
+                rows.push_back(std::move(row));
+            }
+            if (wantList) variables["commits_list_html"] = commitsHtml_content;
+            if (needs.stats) {
+                variables["total_additions"]     = std::to_string(totals.additions);
+                variables["total_deletions"]     = std::to_string(totals.deletions);
+                variables["total_changed_files"] = std::to_string(totals.changedFiles);
             }
-            variables["commits_list_html"] = commitsHtml_content;
+            CompiledTemplate::Sections sections;
+            if (compiled.hasSection("commits")) sections["commits"] = std::move(rows);
 
             // 根据commits数量添加适当的CSS类
             std::string commitListClass = "";
             if (commits.size() <= 2) commitListClass = "few-commits";
             else if (commits.size() >= 6) commitListClass = "many-commits";
             variables["commit_list_class"] = commitListClass;
-            std::string templateHtmlPath   = m_style_dir + "/index.html";
-            std::string renderedHtmlPath   = m_style_dir + "/rendered.html";
 
             // 使用仓库名称构建输出文件名
             std::string filename = owner + "_" + repo;
             // 替换文件名中的特殊字符
             std::replace(filename.begin(), filename.end(), '/', '_');
 
-            // 使用指定的输出目录
-            std::string screenshotImagePath = m_output_dir + "/" + filename + ".png";
+            // 渲染结果直接在内存中交给截图脚本，不再写入共享的rendered.html
+            // 模板来自内置主题或样式目录中的覆盖文件，只在首次渲染时读取
+            return {owner, repo, m_screenshotManager.renderThemeTemplate(variables, sections),
+                    m_output_dir + "/" + filename, config->getOutputSpecs()};
+        }
 
+        // 截图阶段：所有输出规格共享一次页面加载，每个额外规格只多一次截图
+        bool renderCard(RenderedCard const& card) {
             // 确保输出目录存在
             if (!std::filesystem::exists(m_output_dir)) {
                 try {
@@ -441,16 +1205,13 @@ namespace Yume {
                 }
             }
 
-            if (screenshotManager.generateTemplate(templateHtmlPath, variables, renderedHtmlPath)) {
-                if (screenshotManager.takeScreenshot(renderedHtmlPath, screenshotImagePath)) {
-                    std::cout << "成功生成仓库 " << owner << "/" << repo
-                              << " 的更新截图: " << screenshotImagePath << std::endl;
-                } else {
-                    std::cerr << "生成截图失败！" << std::endl;
-                }
-            } else {
-                std::cerr << "生成HTML文件失败！" << std::endl;
+            if (!m_screenshotManager.renderHtml(card.html, card.basePath, card.specs)) {
+                std::cerr << "生成截图失败！" << std::endl;
+                return false;
             }
+            std::cout << "成功生成仓库 " << card.owner << "/" << card.repo
+                      << " 的更新截图: " << card.specs.front().pathFor(card.basePath) << std::endl;
+            return true;
         }
     };
 }
@@ -109,6 +109,7 @@
 #endif
 
 // 标准C++头文件
+#include <atomic>
 #include <chrono>
 #include <cstdlib>
 #include <filesystem>
@@ -117,6 +118,7 @@
 #include <iostream>
 #include <map>
 #include <memory>
+#include <optional>
 #include <random>
 #include <regex>
 #include <sstream>
@@ -147,6 +149,7 @@
 
     #include <sys/stat.h>
     #include <sys/types.h>
+    #include <sys/wait.h>
     #ifdef YUMECARD_PLATFORM_LINUX
         #include <pthread.h>
 
@@ -0,0 +1,361 @@
+//
+// 提交历史存储：已获取的提交按批次压缩（zlib）后追加到 history/segment-NNNNNN.dat，
+// 每个仓库的时间索引记录在 index.log 中，按时间查询时只解压时间范围相关的帧，不需要调用API
+//
+
+#pragma once
+
+#include <mutex>
+#include <set>
+
+#include "head.hpp"
+#include "platform_utils.hpp"
+
+#include <zlib.h>
+
+namespace Yume {
+
+    struct HistoryRecord {
+        std::string sha;
+        std::string date; // GitHub返回的ISO 8601时间
+        std::string author;
+        std::string message;
+        std::string url;
+        std::string avatarUrl;
+        bool        verified = false;
+        int64_t     time     = 0; // date对应的Unix秒，无法解析时为0
+
+        nlohmann::json toJson() const {
+            return {
+                {     "sha",       sha},
+                {    "date",      date},
+                {  "author",    author},
+                { "message",   message},
+                {     "url",       url},
+                {  "avatar", avatarUrl},
+                {"verified",  verified},
+                {    "time",      time}
+            };
+        }
+
+        HistoryRecord static fromJson(nlohmann::json const& json) {
+            HistoryRecord record;
+            record.sha       = json.value("sha", "");
+            record.date      = json.value("date", "");
+            record.author    = json.value("author", "");
+            record.message   = json.value("message", "");
+            record.url       = json.value("url", "");
+            record.avatarUrl = json.value("avatar", "");
+            record.verified  = json.value("verified", false);
+            record.time      = json.value("time", int64_t{0});
+            return record;
+        }
+    };
+
+    class HistoryStore {
+    public:
+        // 单个段文件超过该大小后写入新段
+        static constexpr uint64_t kSegmentLimit = 8ULL * 1024 * 1024;
+
+        // readOnly时只加载索引，供history命令在监控运行时查询
+        explicit HistoryStore(std::string directory, bool readOnly = false):
+            m_directory(std::move(directory)), m_readOnly(readOnly) {
+            loadIndex();
+        }
+
+        ~HistoryStore() {
+            std::lock_guard lock(m_mutex);
+            if (m_segment) std::fclose(m_segment);
+            if (m_indexFile) std::fclose(m_indexFile);
+        }
+
+        HistoryStore(HistoryStore const&)            = delete;
+        HistoryStore& operator=(HistoryStore const&) = delete;
+
+        // 配置文件所在目录下的 history/；分片模式下每个工作进程使用 history/workers/<ID>/
+        std::string static directoryFor(std::string const& configPath,
+                                        std::string const& workerId = "") {
+            auto directory = std::filesystem::path(configPath).parent_path() / "history";
+            if (!workerId.empty()) directory = directory / "workers" / workerId;
+            return directory.string();
+        }
+
+        // 单进程与各工作进程的全部历史目录
+        std::vector<std::string> static directoriesFor(std::string const& configPath) {
+            std::vector<std::string> directories{directoryFor(configPath)};
+            std::error_code          ec;
+            auto                     workers = std::filesystem::path(directories.front()) / "workers";
+            for (auto const& entry : std::filesystem::directory_iterator(workers, ec))
+                if (entry.is_directory()) directories.push_back(entry.path().string());
+            return directories;
+        }
+
+        // 解析 "2025-05-30T12:34:56Z" 或 "2025-05-30"（UTC），失败时返回0
+        int64_t static parseTime(std::string const& text) {
+            std::tm            tm{};
+            std::istringstream in(text);
+            in >> std::get_time(&tm, "%Y-%m-%dT%H:%M:%S");
+            if (in.fail()) {
+                tm = {};
+                in.clear();
+                in.str(text);
+                in >> std::get_time(&tm, "%Y-%m-%d");
+                if (in.fail()) return 0;
+            }
+#ifdef YUMECARD_PLATFORM_WINDOWS
+            return static_cast<int64_t>(_mkgmtime(&tm));
+#else
+            return static_cast<int64_t>(timegm(&tm));
+#endif
+        }
+
+        // 把一个仓库的一批提交压缩为一帧追加到当前段，再记录索引
+        bool append(std::string const& key, std::vector<HistoryRecord> const& records) {
+            if (records.empty() || m_readOnly) return false;
+
+            nlohmann::json payload = nlohmann::json::array();
+            int64_t        first = std::numeric_limits<int64_t>::max(), last = 0;
+            for (auto const& record : records) {
+                payload.push_back(record.toJson());
+                first = std::min(first, record.time);
+                last  = std::max(last, record.time);
+            }
+            std::string raw        = payload.dump();
+            std::string compressed = compress(raw);
+            if (compressed.empty()) {
+                std::cerr << "压缩提交历史失败: " << key << std::endl;
+                return false;
+            }
+
+            std::lock_guard lock(m_mutex);
+            if (!openSegmentLocked()) return false;
+
+            FrameHeader header{kFrameMagic, static_cast<uint32_t>(raw.size()),
+                               static_cast<uint32_t>(compressed.size()), checksum(raw)};
+            FrameRef    frame{m_segmentNumber, m_segmentSize,
+                           static_cast<uint32_t>(sizeof(header) + compressed.size()), first, last,
+                           static_cast<uint32_t>(records.size())};
+            bool ok = std::fwrite(&header, sizeof(header), 1, m_segment) == 1
+                   && std::fwrite(compressed.data(), 1, compressed.size(), m_segment) == compressed.size()
+                   && std::fflush(m_segment) == 0;
+            if (!ok) {
+                std::cerr << "写入提交历史失败: " << segmentPath(m_segmentNumber) << std::endl;
+                return false;
+            }
+            m_segmentSize += frame.size;
+
+            // 先写帧再写索引：崩溃时最多留下一个没有索引的帧，不会出现指向不完整数据的索引
+            nlohmann::json line = {
+                {"repo",    key},
+                { "seg", frame.segment},
+                { "off",  frame.offset},
+                { "len",    frame.size},
+                {"from",   frame.first},
+                {  "to",    frame.last},
+                {   "n",   frame.count}
+            };
+            std::string text = line.dump() + "\n";
+            if (m_indexFile) {
+                std::fwrite(text.data(), 1, text.size(), m_indexFile);
+                std::fflush(m_indexFile);
+            }
+            m_index[key].push_back(frame);
+            return true;
+        }
+
+        // 查询一个仓库since（Unix秒）之后的提交，按时间从新到旧排列，同一SHA只出现一次
+        std::vector<HistoryRecord> query(std::string const& key, int64_t since = 0) const {
+            std::vector<FrameRef> frames;
+            {
+                std::lock_guard lock(m_mutex);
+                auto            it = m_index.find(key);
+                if (it == m_index.end()) return {};
+                for (auto const& frame : it->second)
+                    if (frame.last >= since) frames.push_back(frame);
+            }
+
+            std::vector<HistoryRecord> result;
+            std::set<std::string>      seen;
+            for (auto it = frames.rbegin(); it != frames.rend(); ++it) {
+                for (auto& record : readFrame(*it)) {
+                    if (record.time < since || !seen.insert(record.sha).second) continue;
+                    result.push_back(std::move(record));
+                }
+            }
+            auto newer = [](HistoryRecord const& a, HistoryRecord const& b) { return a.time > b.time; };
+            std::stable_sort(result.begin(), result.end(), newer);
+            return result;
+        }
+
+        // 已记录的提交数（含重复），不读取段文件
+        size_t count(std::string const& key) const {
+            std::lock_guard lock(m_mutex);
+            auto            it = m_index.find(key);
+            if (it == m_index.end()) return 0;
+            size_t total = 0;
+            for (auto const& frame : it->second) total += frame.count;
+            return total;
+        }
+
+    private:
+        // 帧头之后是zlib压缩的JSON数组；checksum为解压后内容的CRC32
+        struct FrameHeader {
+            uint32_t magic;
+            uint32_t rawSize;
+            uint32_t compressedSize;
+            uint32_t checksum;
+        };
+
+        struct FrameRef {
+            uint32_t segment;
+            uint64_t offset;
+            uint32_t size;
+            int64_t  first;
+            int64_t  last;
+            uint32_t count;
+        };
+
+        static constexpr uint32_t kFrameMagic = 0x46484359; // "YCHF"
+
+        std::string                                  m_directory;
+        bool                                         m_readOnly;
+        mutable std::mutex                           m_mutex;
+        std::map<std::string, std::vector<FrameRef>> m_index;
+        std::FILE*                                   m_segment       = nullptr;
+        std::FILE*                                   m_indexFile     = nullptr;
+        uint32_t                                     m_segmentNumber = 0;
+        uint64_t                                     m_segmentSize   = 0;
+
+        std::string indexPath() const { return PathUtils::joinPath(m_directory, "index.log"); }
+
+        std::string segmentPath(uint32_t segment) const {
+            std::ostringstream name;
+            name << "segment-" << std::setw(6) << std::setfill('0') << segment << ".dat";
+            return PathUtils::joinPath(m_directory, name.str());
+        }
+
+        uint32_t static checksum(std::string const& data) {
+            uLong crc = crc32(0L, Z_NULL, 0);
+            crc = crc32(crc, reinterpret_cast<Bytef const*>(data.data()), static_cast<uInt>(data.size()));
+            return static_cast<uint32_t>(crc);
+        }
+
+        std::string static compress(std::string const& raw) {
+            uLongf      size = compressBound(static_cast<uLong>(raw.size()));
+            std::string out(size, '\0');
+            int         code = compress2(reinterpret_cast<Bytef*>(out.data()), &size,
+                                         reinterpret_cast<Bytef const*>(raw.data()),
+                                         static_cast<uLong>(raw.size()), Z_BEST_COMPRESSION);
+            if (code != Z_OK) return "";
+            out.resize(size);
+            return out;
+        }
+
+        // 逐行读取索引；无法解析的尾部（崩溃时写了一半）在可写模式下截掉
+        void loadIndex() {
+            std::ifstream in(indexPath(), std::ios::binary);
+            if (in.is_open()) {
+                std::string line;
+                uintmax_t   validLength = 0;
+                bool        truncated   = false;
+                while (std::getline(in, line)) {
+                    if (in.eof()) {
+                        truncated = true;
+                        break;
+                    }
+                    try {
+                        nlohmann::json record = nlohmann::json::parse(line);
+                        FrameRef frame{record.at("seg").get<uint32_t>(), record.at("off").get<uint64_t>(),
+                                       record.at("len").get<uint32_t>(), record.at("from").get<int64_t>(),
+                                       record.at("to").get<int64_t>(),   record.at("n").get<uint32_t>()};
+                        m_index[record.at("repo").get<std::string>()].push_back(frame);
+                        m_segmentNumber = std::max(m_segmentNumber, frame.segment);
+                    } catch (nlohmann::json::exception const&) {
+                        truncated = true;
+                        break;
+                    }
+                    validLength += line.size() + 1;
+                }
+                in.close();
+                if (truncated && !m_readOnly) {
+                    std::error_code ec;
+                    std::filesystem::resize_file(indexPath(), validLength, ec);
+                }
+            }
+        }
+
+        bool openSegmentLocked() {
+            if (m_segment && m_segmentSize < kSegmentLimit) return true;
+
+            std::error_code ec;
+            std::filesystem::create_directories(m_directory, ec);
+            if (ec) {
+                std::cerr << "无法创建历史目录: " << m_directory << " - " << ec.message() << std::endl;
+                return false;
+            }
+            if (!m_indexFile) {
+                m_indexFile = std::fopen(indexPath().c_str(), "ab");
+                if (!m_indexFile) std::cerr << "无法打开历史索引: " << indexPath() << std::endl;
+            }
+
+            if (m_segment) {
+                std::fclose(m_segment);
+                m_segment = nullptr;
+                ++m_segmentNumber;
+            }
+            // 新进程续写最后一个段（或在它已满时开新段）；未被索引的尾部帧不影响查询
+            for (;;) {
+                auto size = std::filesystem::file_size(segmentPath(m_segmentNumber), ec);
+                if (ec || size < kSegmentLimit) {
+                    m_segmentSize = ec ? 0 : size;
+                    break;
+                }
+                ++m_segmentNumber;
+            }
+            m_segment = std::fopen(segmentPath(m_segmentNumber).c_str(), "ab");
+            if (!m_segment) {
+                std::cerr << "无法打开历史段文件: " << segmentPath(m_segmentNumber) << std::endl;
+                return false;
+            }
+            return true;
+        }
+
+        std::vector<HistoryRecord> readFrame(FrameRef const& frame) const {
+            std::vector<HistoryRecord> records;
+            std::ifstream              in(segmentPath(frame.segment), std::ios::binary);
+            if (!in.is_open()) return records;
+            in.seekg(static_cast<std::streamoff>(frame.offset));
+
+            FrameHeader header{};
+            in.read(reinterpret_cast<char*>(&header), sizeof(header));
+            if (!in || header.magic != kFrameMagic
+                || sizeof(header) + header.compressedSize != frame.size) {
+                std::cerr << "历史帧损坏: " << segmentPath(frame.segment) << " @" << frame.offset
+                          << std::endl;
+                return records;
+            }
+            std::string compressed(header.compressedSize, '\0');
+            in.read(compressed.data(), static_cast<std::streamsize>(compressed.size()));
+            if (!in) return records;
+
+            std::string raw(header.rawSize, '\0');
+            uLongf      rawSize = header.rawSize;
+            int         code    = uncompress(reinterpret_cast<Bytef*>(raw.data()), &rawSize,
+                                             reinterpret_cast<Bytef const*>(compressed.data()),
+                                             static_cast<uLong>(compressed.size()));
+            if (code != Z_OK || rawSize != header.rawSize || checksum(raw) != header.checksum) {
+                std::cerr << "历史帧校验失败: " << segmentPath(frame.segment) << " @" << frame.offset
+                          << std::endl;
+                return records;
+            }
+            try {
+                for (auto const& item : nlohmann::json::parse(raw))
+                    records.push_back(HistoryRecord::fromJson(item));
+            } catch (nlohmann::json::exception const& e) {
+                std::cerr << "历史帧解析失败: " << e.what() << std::endl;
+            }
+            return records;
+        }
+    };
+
+} // namespace Yume
@@ -0,0 +1,135 @@
+//
+// 提交信息格式化：HTML转义、emoji短代码、**粗体**与`代码`，一次线性扫描完成
+//
+
+#pragma once
+
+#include <algorithm>
+#include <string>
+#include <string_view>
+
+#include "emoji_table.hpp"
+
+namespace Yume {
+
+    class MessageFormatter {
+    public:
+        // 提交信息的第一行（摘要），去掉行尾的\r
+        std::string_view static summary(std::string_view message) {
+            size_t end = message.find('\n');
+            if (end != std::string_view::npos) message = message.substr(0, end);
+            if (!message.empty() && message.back() == '\r') message.remove_suffix(1);
+            return message;
+        }
+
+        // 将提交信息转换为卡片可直接嵌入的HTML片段；summaryOnly时只保留第一行
+        std::string static toHtml(std::string_view message, bool summaryOnly = true) {
+            std::string_view text = summaryOnly ? summary(message) : message;
+
+            std::string out;
+            out.reserve(text.size() + text.size() / 4);
+
+            bool   inBold       = false;
+            size_t boldOpenPos  = 0;     // 未闭合时回退用
+            bool   noCodeCloser = false; // 之后已不存在反引号，无需再向后查找
+
+            for (size_t i = 0; i < text.size();) {
+                char c = text[i];
+
+                // `代码`：原样转义输出，内部不做emoji与粗体处理
+                if (c == '`' && !noCodeCloser) {
+                    size_t close = text.find('`', i + 1);
+                    if (close == std::string_view::npos) {
+                        noCodeCloser = true;
+                    } else {
+                        out += "<code>";
+                        appendEscaped(out, text.substr(i + 1, close - i - 1));
+                        out += "</code>";
+                        i = close + 1;
+                        continue;
+                    }
+                }
+
+                // **粗体**：按开关处理，结尾仍未闭合时把开标签还原为字面量
+                if (c == '*' && i + 1 < text.size() && text[i + 1] == '*') {
+                    if (!inBold) {
+                        boldOpenPos = out.size();
+                        out += "<strong>";
+                    } else {
+                        out += "</strong>";
+                    }
+                    inBold = !inBold;
+                    i += 2;
+                    continue;
+                }
+
+                // :shortcode:，向后最多看kMaxShortcode个字符
+                if (c == ':') {
+                    size_t length = shortcodeLength(text, i + 1);
+                    if (length > 0) {
+                        std::string_view emoji = lookupEmoji(text.substr(i + 1, length));
+                        if (!emoji.empty()) {
+                            out += emoji;
+                            i += length + 2;
+                            continue;
+                        }
+                    }
+                }
+
+                if (c == '\n') {
+                    out += "<br>";
+                    ++i;
+                    continue;
+                }
+                if (c == '\r') {
+                    ++i;
+                    continue;
+                }
+
+                appendEscaped(out, text.substr(i, 1));
+                ++i;
+            }
+
+            if (inBold) out.replace(boldOpenPos, 8, "**");
+            return out;
+        }
+
+        // HTML转义
+        void static appendEscaped(std::string& out, std::string_view text) {
+            for (char c : text) {
+                switch (c) {
+                    case '&':  out += "&amp;"; break;
+                    case '<':  out += "&lt;"; break;
+                    case '>':  out += "&gt;"; break;
+                    case '"':  out += "&quot;"; break;
+                    case '\'': out += "&#39;"; break;
+                    default:   out += c; break;
+                }
+            }
+        }
+
+        std::string static escape(std::string_view text) {
+            std::string out;
+            out.reserve(text.size());
+            appendEscaped(out, text);
+            return out;
+        }
+
+    private:
+        static constexpr size_t kMaxShortcode = 40;
+
+        // 从start开始的合法短代码长度（到下一个冒号为止），不合法返回0
+        size_t static shortcodeLength(std::string_view text, size_t start) {
+            size_t limit = std::min(text.size(), start + kMaxShortcode + 1);
+            for (size_t i = start; i < limit; ++i) {
+                char c = text[i];
+                if (c == ':') return i - start;
+                bool valid = (c >= 'a' && c <= 'z') || (c >= '0' && c <= '9') || c == '_' || c == '+'
+                          || c == '-';
+                if (!valid) return 0;
+            }
+            return 0;
+        }
+    };
+
+} // namespace Yume
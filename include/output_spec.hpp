@@ -0,0 +1,52 @@
+//
+// 截图输出规格
+//
+
+#pragma once
+
+#include "head.hpp"
+
+namespace Yume {
+
+    // 截图区域
+    struct ClipRect {
+        double x = 0, y = 0, width = 0, height = 0;
+    };
+
+    // 一种输出规格：同一次页面加载可产出多种尺寸/裁剪/格式
+    struct OutputSpec {
+        std::string             suffix;           // 输出文件名后缀，空表示主输出
+        double                  scale   = 1.0;    // 设备缩放倍率，如0.5缩略图、2视网膜
+        std::string             clip    = "card"; // card: 卡片区域, page: 整页
+        std::optional<ClipRect> rect;             // 指定时覆盖clip
+        std::string             format  = "png";  // png / jpeg / webp
+        int                     quality = 90;     // 仅jpeg/webp有效
+
+        std::string extension() const { return format == "jpeg" ? ".jpg" : "." + format; }
+
+        // 由不带扩展名的基础路径生成该规格的输出路径
+        std::string pathFor(std::string const& basePath) const {
+            return basePath + (suffix.empty() ? "" : "_" + suffix) + extension();
+        }
+
+        nlohmann::json toJson(std::string const& path) const {
+            nlohmann::json spec;
+            spec["path"]    = path;
+            spec["scale"]   = scale;
+            spec["format"]  = format;
+            spec["quality"] = quality;
+            if (rect) {
+                spec["clip"] = {
+                    {     "x",      rect->x},
+                    {     "y",      rect->y},
+                    { "width",  rect->width},
+                    {"height", rect->height}
+                };
+            } else {
+                spec["clip"] = clip;
+            }
+            return spec;
+        }
+    };
+
+} // namespace Yume
@@ -61,6 +61,31 @@ namespace Yume {
             // failure to execute the command itself.
             return result;
         }
+
+        // 执行命令并将input写入其标准输入，返回退出码（无法启动时返回-1）
+        int static executeCommandWithInput(std::string const& command, std::string const& input) {
+#ifdef YUMECARD_PLATFORM_WINDOWS
+            FILE* pipe = _popen(command.c_str(), "wb");
+#else
+            FILE* pipe = popen(command.c_str(), "w");
+#endif
+            if (!pipe) {
+                std::cerr << "CommandUtils::executeCommandWithInput: 无法启动命令: " << command << std::endl;
+                return -1;
+            }
+
+            size_t written = std::fwrite(input.data(), 1, input.size(), pipe);
+            if (written != input.size())
+                std::cerr << "CommandUtils::executeCommandWithInput: 写入标准输入不完整" << std::endl;
+
+#ifdef YUMECARD_PLATFORM_WINDOWS
+            return _pclose(pipe);
+#else
+            int status = pclose(pipe);
+            if (status == -1) return -1;
+            return WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+#endif
+        }
     };
 
 } // namespace Yume
@@ -5,6 +5,12 @@
 
 #include <head.hpp>
 
+#include "adaptive_polling.hpp"
+#include "background_cache.hpp"
+#include "card_coalescer.hpp"
+#include "output_spec.hpp"
+#include "repository_registry.hpp"
+
 namespace Yume {
     class ReadConfig {
     public:
@@ -16,8 +22,14 @@ namespace Yume {
             } else {
                 std::cerr << "无法打开配置文件: " << m_config_path << std::endl;
             }
+            m_registry = RepositoryRegistry::fromConfig(m_config);
         }
 
+        // 从已解析的配置构建，供ConfigService发布快照
+        ReadConfig(std::string config_path, nlohmann::json config):
+            m_config_path(std::move(config_path)), m_config(std::move(config)),
+            m_registry(RepositoryRegistry::fromConfig(m_config)) {}
+
         ~ReadConfig() = default;
 
         [[nodiscard]] std::string getToken() const {
@@ -28,60 +40,91 @@ namespace Yume {
 
         [[nodiscard]] std::vector<std::string> getRepository() const {
             std::vector<std::string> result;
-            auto                     repository = m_config["GitHub"]["repository"];
-            for (auto const& repos : repository) {
-                std::string owner = repos["owner"].get<std::string>();
-                std::string repo  = repos["repo"].get<std::string>();
-                result.emplace_back(std::move(owner) + "/" + std::move(repo));
-            }
+            result.reserve(m_registry.size());
+            for (auto const& entry : m_registry.entries()) result.push_back(entry.fullName());
             return result;
         }
 
-        // 获取特定仓库的最后一次提交SHA
+        // 订阅仓库注册表，按 owner/repo 索引
+        [[nodiscard]] RepositoryRegistry const& repositories() const { return m_registry; }
+
+        // 获取旧版配置中记录的最后一次提交SHA（现由StateJournal保存，仅用于迁移）
         [[nodiscard]] std::string getLastSha(std::string const& owner, std::string const& repo) const {
-            if (m_config.contains("GitHub") && m_config["GitHub"].contains("repository")) {
-                auto repository = m_config["GitHub"]["repository"];
-                for (auto const& repos : repository) {
-                    if (repos["owner"].get<std::string>() == owner
-                        && repos["repo"].get<std::string>() == repo) {
-                        if (repos.contains("lastsha")) return repos["lastsha"].get<std::string>();
-                        break;
-                    }
-                }
-            }
-            return "";
+            auto const* entry = m_registry.find(owner, repo);
+            return entry ? entry->legacyLastSha : "";
         }
 
         // 获取所有仓库的详细信息
-        [[nodiscard]] std::vector<nlohmann::json> getAllRepositories() const {
-            std::vector<nlohmann::json> result;
-            if (m_config.contains("GitHub") && m_config["GitHub"].contains("repository")) {
-                auto repository = m_config["GitHub"]["repository"];
-                for (auto const& repos : repository) result.push_back(repos);
-            }
-            return result;
+        [[nodiscard]] std::vector<RepositoryEntry> const& getAllRepositories() const {
+            return m_registry.entries();
         }
 
-        // 获取特定仓库的分支 (占位符实现)
+        // 获取特定仓库的分支，未配置时为main
         [[nodiscard]] std::string getBranch(std::string const& owner, std::string const& repo) const {
-            if (m_config.contains("GitHub") && m_config["GitHub"].contains("repository")) {
-                for (auto const& r : m_config["GitHub"]["repository"])
-                    if (r.value("owner", "") == owner && r.value("repo", "") == repo)
-                        return r.value("branch", "main"); // Default to main if not specified
-            }
-            return "main"; // Default if repo not found
-        } // 获取特定仓库的描述 (占位符实现)
+            auto const* entry = m_registry.find(owner, repo);
+            return entry ? entry->branch : "main";
+        }
+
+        // 获取特定仓库的描述
         [[nodiscard]] std::string getDescription(std::string const& owner,
                                                  std::string const& repo) const {
-            // Placeholder: In a real scenario, you might fetch this from config or elsewhere
-            // For now, returning an empty string or a generic description.
-            if (m_config.contains("GitHub") && m_config["GitHub"].contains("repository")) {
-                for (auto const& r : m_config["GitHub"]["repository"])
-                    if (r.value("owner", "") == owner && r.value("repo", "") == repo)
-                        return r.value("description", ""); // Assuming description might be in config
+            auto const* entry = m_registry.find(owner, repo);
+            return entry ? entry->description : "";
+        }
+
+        // 获取监控时并发检查仓库的线程数 GitHub.workers，默认4
+        [[nodiscard]] size_t getWorkerCount() const {
+            if (m_config.contains("GitHub") && m_config["GitHub"].contains("workers")
+                && m_config["GitHub"]["workers"].is_number_integer())
+                return static_cast<size_t>(std::clamp(m_config["GitHub"]["workers"].get<int>(), 1, 64));
+            return 4;
+        }
+
+        // 获取监控时同时截图的线程数 GitHub.renderers，默认1（每个截图启动一个浏览器进程）
+        [[nodiscard]] size_t getRendererCount() const {
+            if (m_config.contains("GitHub") && m_config["GitHub"].contains("renderers")
+                && m_config["GitHub"]["renderers"].is_number_integer())
+                return static_cast<size_t>(std::clamp(m_config["GitHub"]["renderers"].get<int>(), 1, 16));
+            return 1;
+        }
+
+        // 获取监控停止时等待进行中的检查完成的最长时间 GitHub.drainTimeout（秒），默认30
+        [[nodiscard]] std::chrono::seconds getDrainTimeout() const {
+            if (m_config.contains("GitHub") && m_config["GitHub"].contains("drainTimeout")
+                && m_config["GitHub"]["drainTimeout"].is_number_integer())
+                return std::chrono::seconds(
+                    std::clamp(m_config["GitHub"]["drainTimeout"].get<int>(), 0, 600));
+            return std::chrono::seconds(30);
+        }
+
+        // 获取自适应轮询的全局上下限 GitHub.polling: {minInterval, maxInterval}（分钟）
+        [[nodiscard]] PollBounds getPollBounds() const {
+            PollBounds bounds;
+            if (m_config.contains("GitHub") && m_config["GitHub"].contains("polling")
+                && m_config["GitHub"]["polling"].is_object()) {
+                auto const& polling = m_config["GitHub"]["polling"];
+                bounds.minSeconds   = std::max<int64_t>(1, polling.value("minInterval", int64_t{2})) * 60;
+                bounds.maxSeconds   = polling.value("maxInterval", int64_t{60}) * 60;
+                bounds.maxSeconds   = std::max(bounds.minSeconds, bounds.maxSeconds);
             }
-            return "";
-        } // 获取背景图片配置
+            return bounds;
+        }
+
+        // 获取卡片合并窗口 GitHub.coalesce: {quietPeriod, maxDelay}（分钟），quietPeriod为0（默认）时不合并
+        [[nodiscard]] CoalesceWindow getCoalesceWindow() const {
+            CoalesceWindow window;
+            if (m_config.contains("GitHub") && m_config["GitHub"].contains("coalesce")
+                && m_config["GitHub"]["coalesce"].is_object()) {
+                auto const& coalesce   = m_config["GitHub"]["coalesce"];
+                int64_t     quiet      = coalesce.value("quietPeriod", int64_t{0});
+                int64_t     maxDelay   = coalesce.value("maxDelay", int64_t{15});
+                window.quietSeconds    = std::max<int64_t>(0, quiet) * 60;
+                window.maxDelaySeconds = std::max(window.quietSeconds, maxDelay * 60);
+            }
+            return window;
+        }
+
+        // 获取背景图片配置
         [[nodiscard]] bool getBackgroundsEnabled() const {
             if (m_config.contains("GitHub") && m_config["GitHub"].contains("backgrounds")) {
                 auto backgroundsValue = m_config["GitHub"]["backgrounds"];
@@ -95,8 +138,72 @@ namespace Yume {
             return false; // 默认不启用背景图片
         }
 
+        // 获取背景选择模式: random / weighted / repo
+        [[nodiscard]] std::string getBackgroundMode() const {
+            if (m_config.contains("GitHub") && m_config["GitHub"].contains("backgroundMode")
+                && m_config["GitHub"]["backgroundMode"].is_string())
+                return m_config["GitHub"]["backgroundMode"].get<std::string>();
+            return "random";
+        }
+
+        // 获取背景图片权重（文件名 -> 权重），用于weighted模式
+        [[nodiscard]] std::map<std::string, double> getBackgroundWeights() const {
+            std::map<std::string, double> result;
+            if (m_config.contains("GitHub") && m_config["GitHub"].contains("backgroundWeights")
+                && m_config["GitHub"]["backgroundWeights"].is_object()) {
+                for (auto const& [name, weight] : m_config["GitHub"]["backgroundWeights"].items())
+                    if (weight.is_number()) result[name] = weight.get<double>();
+            }
+            return result;
+        }
+
+        // 获取背景预缩放参数 GitHub.backgroundScale: {enabled, width, height, deviceScale, quality}
+        [[nodiscard]] BackgroundScaleOptions getBackgroundScaleOptions() const {
+            BackgroundScaleOptions options;
+            if (m_config.contains("GitHub") && m_config["GitHub"].contains("backgroundScale")
+                && m_config["GitHub"]["backgroundScale"].is_object()) {
+                auto const& scale   = m_config["GitHub"]["backgroundScale"];
+                options.enabled     = scale.value("enabled", options.enabled);
+                options.width       = std::max(1, scale.value("width", options.width));
+                options.height      = std::max(1, scale.value("height", options.height));
+                options.deviceScale = std::max(0.1, scale.value("deviceScale", options.deviceScale));
+                options.quality     = std::clamp(scale.value("quality", options.quality), 1, 100);
+            }
+            return options;
+        }
+
+        // 获取输出规格 GitHub.outputs: [{suffix, scale, clip, format, quality}]，未配置时为单个PNG
+        [[nodiscard]] std::vector<OutputSpec> getOutputSpecs() const {
+            std::vector<OutputSpec> specs;
+            if (m_config.contains("GitHub") && m_config["GitHub"].contains("outputs")
+                && m_config["GitHub"]["outputs"].is_array()) {
+                for (auto const& item : m_config["GitHub"]["outputs"]) {
+                    if (!item.is_object()) continue;
+                    OutputSpec spec;
+                    spec.suffix  = item.value("suffix", spec.suffix);
+                    spec.scale   = std::max(0.1, item.value("scale", spec.scale));
+                    spec.format  = item.value("format", spec.format);
+                    spec.quality = std::clamp(item.value("quality", spec.quality), 1, 100);
+                    if (spec.format == "jpg") spec.format = "jpeg";
+                    if (spec.format != "png" && spec.format != "jpeg" && spec.format != "webp")
+                        spec.format = "png";
+                    if (item.contains("clip") && item["clip"].is_object()) {
+                        auto const& clip = item["clip"];
+                        spec.rect        = ClipRect{clip.value("x", 0.0), clip.value("y", 0.0),
+                                                    clip.value("width", 0.0), clip.value("height", 0.0)};
+                    } else if (item.contains("clip") && item["clip"].is_string()) {
+                        spec.clip = item["clip"].get<std::string>();
+                    }
+                    specs.push_back(std::move(spec));
+                }
+            }
+            if (specs.empty()) specs.emplace_back();
+            return specs;
+        }
+
     private:
-        std::string    m_config_path = "./config/config.json";
-        nlohmann::json m_config;
+        std::string        m_config_path = "./config/config.json";
+        nlohmann::json     m_config;
+        RepositoryRegistry m_registry;
     };
 }
@@ -0,0 +1,154 @@
+//
+// 订阅仓库注册表：从配置中的 GitHub.repository 数组构建一次，按 owner/repo 哈希索引
+// 查找时不拼接键字符串，也不复制JSON
+//
+
+#pragma once
+
+#include <string_view>
+#include <unordered_map>
+
+#include "head.hpp"
+
+namespace Yume {
+
+    struct RepositoryEntry {
+        std::string    owner;
+        std::string    repo;
+        std::string    branch = "main";
+        std::string    description;
+        std::string    legacyLastSha; // 旧版配置中的lastsha，仅用于迁移到StateJournal
+        nlohmann::json extra = nlohmann::json::object(); // 其余字段，写回配置时保留
+
+        std::string fullName() const { return owner + "/" + repo; }
+
+        nlohmann::json toJson() const {
+            nlohmann::json json = extra;
+            json["owner"]       = owner;
+            json["repo"]        = repo;
+            json["branch"]      = branch;
+            if (!description.empty()) json["description"] = description;
+            if (!legacyLastSha.empty()) json["lastsha"] = legacyLastSha;
+            return json;
+        }
+
+        // owner与repo必须是非空字符串，否则返回std::nullopt
+        std::optional<RepositoryEntry> static fromJson(nlohmann::json const& json) {
+            if (!json.is_object()) return std::nullopt;
+            auto text = [&json](char const* key) -> std::string {
+                auto it = json.find(key);
+                return it != json.end() && it->is_string() ? it->get<std::string>() : "";
+            };
+
+            RepositoryEntry entry;
+            entry.owner = text("owner");
+            entry.repo  = text("repo");
+            if (entry.owner.empty() || entry.repo.empty()) return std::nullopt;
+            std::string branch  = text("branch");
+            entry.branch        = branch.empty() ? "main" : branch;
+            entry.description   = text("description");
+            entry.legacyLastSha = text("lastsha");
+            for (auto const& [key, value] : json.items())
+                if (key != "owner" && key != "repo" && key != "branch" && key != "description"
+                    && key != "lastsha")
+                    entry.extra[key] = value;
+            return entry;
+        }
+    };
+
+    class RepositoryRegistry {
+    public:
+        RepositoryRegistry() = default;
+
+        explicit RepositoryRegistry(nlohmann::json const& repositories) {
+            if (!repositories.is_array()) return;
+            m_entries.reserve(repositories.size());
+            m_index.reserve(repositories.size());
+            for (auto const& item : repositories) {
+                auto entry = RepositoryEntry::fromJson(item);
+                if (!entry) {
+                    std::cerr << "忽略无效的仓库配置: " << item.dump() << std::endl;
+                    continue;
+                }
+                add(std::move(*entry)); // 重复的仓库以第一条为准
+            }
+        }
+
+        // 从完整配置的 GitHub.repository 构建
+        RepositoryRegistry static fromConfig(nlohmann::json const& config) {
+            auto github = config.find("GitHub");
+            if (github == config.end() || !github->is_object()) return {};
+            auto repositories = github->find("repository");
+            if (repositories == github->end()) return {};
+            return RepositoryRegistry(*repositories);
+        }
+
+        RepositoryEntry const* find(std::string_view owner, std::string_view repo) const {
+            auto it = m_index.find(KeyView{owner, repo});
+            return it != m_index.end() ? &m_entries[it->second] : nullptr;
+        }
+
+        bool contains(std::string_view owner, std::string_view repo) const {
+            return find(owner, repo) != nullptr;
+        }
+
+        // 已存在时返回false
+        bool add(RepositoryEntry entry) {
+            std::string key = entry.fullName();
+            if (m_index.count(key)) return false;
+            m_index.emplace(std::move(key), m_entries.size());
+            m_entries.push_back(std::move(entry));
+            return true;
+        }
+
+        std::vector<RepositoryEntry> const& entries() const { return m_entries; }
+
+        size_t size() const { return m_entries.size(); }
+
+        bool empty() const { return m_entries.empty(); }
+
+    private:
+        // 以 owner、repo 两段直接查找，哈希与 "owner/repo" 整串一致
+        struct KeyView {
+            std::string_view owner;
+            std::string_view repo;
+        };
+
+        struct KeyHash {
+            using is_transparent = void;
+
+            size_t static mix(size_t hash, std::string_view text) {
+                for (unsigned char c : text) {
+                    hash ^= c;
+                    hash *= 1099511628211ULL;
+                }
+                return hash;
+            }
+
+            size_t operator()(std::string_view key) const { return mix(14695981039346656037ULL, key); }
+
+            size_t operator()(std::string const& key) const { return (*this)(std::string_view(key)); }
+
+            size_t operator()(KeyView key) const {
+                return mix(mix(mix(14695981039346656037ULL, key.owner), "/"), key.repo);
+            }
+        };
+
+        struct KeyEqual {
+            using is_transparent = void;
+
+            bool operator()(std::string_view a, std::string_view b) const { return a == b; }
+
+            bool operator()(KeyView a, std::string_view b) const {
+                return b.size() == a.owner.size() + 1 + a.repo.size() && b.starts_with(a.owner)
+                    && b[a.owner.size()] == '/' && b.ends_with(a.repo);
+            }
+
+            bool operator()(std::string_view a, KeyView b) const { return (*this)(b, a); }
+        };
+
+        std::vector<RepositoryEntry>                               m_entries;
+        std::unordered_map<std::string, size_t, KeyHash, KeyEqual> m_index;
+    };
+
+} // namespace Yume
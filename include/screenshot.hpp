@@ -4,17 +4,36 @@
 
 #pragma once
 
+#include "background_cache.hpp"
+#include "background_catalogue.hpp"
+#include "compiled_template.hpp"
 #include "head.hpp"
+#include "output_spec.hpp"
 #include "platform_utils.hpp" // Include the new platform utilities
+#include "theme.hpp"
 
 namespace Yume {
+    // 一次渲染任务，id用于区分并发执行的任务及其日志
+    struct RenderJob {
+        std::string id;
+        std::string html;
+        std::string outputPath;
+        int         quality = 100;
+    };
+
     // 用于管理截图功能的类
     class ScreenshotManager {
     private:
-        std::string m_style_dir;
+        std::string                          m_style_dir;
+        ThemeResources                       m_theme; // 内置主题与样式目录中的覆盖文件
+        CompiledTemplate                     m_compiled;
+        std::once_flag                       m_compileOnce;
+        std::unique_ptr<BackgroundCatalogue> m_backgrounds; // 首次使用时建立索引
+        BackgroundVariantCache               m_variants;
 
     public:
-        ScreenshotManager(std::string style_dir = "./Style"): m_style_dir(std::move(style_dir)) {}
+        ScreenshotManager(std::string style_dir = "./Style"):
+            m_style_dir(std::move(style_dir)), m_theme(m_style_dir), m_variants(m_style_dir, m_theme) {}
         ~ScreenshotManager() = default;
 
         // 使用screenshot.js对HTML文件进行截图
@@ -24,35 +43,13 @@ namespace Yume {
             std::string absHtmlPath   = std::filesystem::absolute(htmlPath).string();
             std::string absOutputPath = std::filesystem::absolute(outputPath).string();
 
-            // 确保截图脚本存在于style目录
-            // Assuming getScriptPath() is defined elsewhere, possibly in head.hpp or a utility class
-            // For now, let's ensure it's declared or defined. If it's part of this class, it should be:
-            // std::string scriptPath = this->getScriptPath();
-            // If it's a free function in Yume namespace:
-            // std::string scriptPath = Yume::getScriptPath();
-            // If it's a static method of another class:
-            // std::string scriptPath = AnotherClass::getScriptPath();
-            // For this example, I'll assume it's a member function or a free function accessible here.
-            // If it's missing, it will cause a new compile error.
-            std::string scriptPath      = getScriptPath(); // Placeholder if getScriptPath is not defined
-            std::string debugScriptPath = PathUtils::joinPath(m_style_dir, "screenshot.js");
-
-            // 如果文件不同，则复制更新后的截图脚本
-            if (FileSystemUtils::fileExists(scriptPath)
-                && (!FileSystemUtils::fileExists(debugScriptPath)
-                    || std::filesystem::last_write_time(scriptPath)
-                           > std::filesystem::last_write_time(debugScriptPath))) {
-                if (!FileSystemUtils::copyFile(scriptPath, debugScriptPath)) {
-                    std::cerr << "复制截图脚本失败" << std::endl;
-                    return false;
-                }
-                std::cout << "更新了截图脚本: " << debugScriptPath << std::endl;
-            }
+            std::string scriptPath;
+            if (!ensureScript(scriptPath)) return false;
 
             // 构建跨平台的Node.js命令
             std::vector<std::string> args = {absHtmlPath, absOutputPath, std::to_string(quality)};
 
-            std::string command = CommandUtils::buildNodeCommand(debugScriptPath, args);
+            std::string command = CommandUtils::buildNodeCommand(scriptPath, args);
 
             // 执行命令
             std::cout << "执行截图命令: " << command << std::endl;
@@ -68,31 +65,58 @@ namespace Yume {
             }
         }
 
-        // 生成HTML模板
-        bool generateTemplate(std::string const&                        templatePath,
-                              std::map<std::string, std::string> const& variables,
-                              std::string const&                        outputPath) {
+        // 将内存中的HTML直接交给screenshot.js渲染，不落地临时文件
+        // HTML与任务参数以JSON形式经由标准输入传递，每个任务拥有独立的ID，可并发执行
+        bool renderHtml(std::string const& html, std::string const& outputPath, int quality = 100) {
+            return renderHtml(html, std::vector<std::string>{outputPath}, {OutputSpec{}}, quality);
+        }
+
+        // 一次页面加载与布局产出多种规格；basePath不含扩展名，各规格路径由OutputSpec::pathFor生成
+        bool renderHtml(std::string const& html, std::string const& basePath,
+                        std::vector<OutputSpec> const& specs) {
+            std::vector<std::string> paths;
+            paths.reserve(specs.size());
+            for (auto const& spec : specs) paths.push_back(spec.pathFor(basePath));
+            return renderHtml(html, paths, specs, 100);
+        }
+
+        // 渲染HTML模板并返回结果，失败时返回std::nullopt
+        std::optional<std::string> renderTemplate(std::string const&                        templatePath,
+                                                  std::map<std::string, std::string> const& variables) {
             // 读取模板文件
             std::ifstream templateFile(templatePath);
             if (!templateFile.is_open()) {
                 std::cerr << "无法打开模板文件: " << templatePath << std::endl;
-                return false;
+                return std::nullopt;
             }
 
             std::stringstream buffer;
             buffer << templateFile.rdbuf();
-            std::string content = buffer.str();
             templateFile.close();
+            return applyTemplate(buffer.str(), variables);
+        }
 
-            // 替变量
-            for (auto const& [key, value] : variables)
-                content = replaceAll(content, "{{" + key + "}}", value);
+        // 当前主题的预编译模板（内置或样式目录中的覆盖文件），只在首次使用时读取并解析
+        CompiledTemplate const& themeTemplate() {
+            std::call_once(m_compileOnce,
+                           [this]() { m_compiled = CompiledTemplate(m_theme.templateHtml()); });
+            return m_compiled;
+        }
 
-            // 处理循环标签
-            content = processLoops(content);
+        // 使用当前主题的模板渲染；sections提供 {{#each name}} 区块的各条目变量
+        std::string renderThemeTemplate(std::map<std::string, std::string> const& variables,
+                                        CompiledTemplate::Sections const&         sections = {}) {
+            return themeTemplate().render(variables, sections);
+        }
 
-            // 处理条件标签
-            content = processConditions(content);
+        ThemeResources& theme() { return m_theme; }
+
+        // 生成HTML模板
+        bool generateTemplate(std::string const&                        templatePath,
+                              std::map<std::string, std::string> const& variables,
+                              std::string const&                        outputPath) {
+            auto content = renderTemplate(templatePath, variables);
+            if (!content) return false;
 
             // 保存生成的HTML
             std::ofstream outputFile(outputPath);
@@ -101,50 +125,33 @@ namespace Yume {
                 return false;
             }
 
-            outputFile << content;
+            outputFile << *content;
             outputFile.close();
 
             std::cout << "成功生成HTML文件: " << outputPath << std::endl;
             return true;
-        } // 获取随机背景图片
-        std::string getRandomBackground(std::string const& backgroundDir = "") {
+        }
+
+        // 获取背景图片目录索引，目录变化时重建
+        BackgroundCatalogue& backgroundCatalogue(std::string const& backgroundDir = "") {
             std::string actualBackgroundDir =
                 backgroundDir.empty() ? (m_style_dir + "/backgrounds") : backgroundDir;
+            if (!m_backgrounds || m_backgrounds->directory() != actualBackgroundDir)
+                m_backgrounds = std::make_unique<BackgroundCatalogue>(actualBackgroundDir);
+            return *m_backgrounds;
+        }
 
-            std::vector<std::string> imageFiles;
-
-            // 检查目录是否存在
-            if (!std::filesystem::exists(actualBackgroundDir)
-                || !std::filesystem::is_directory(actualBackgroundDir)) {
-                std::cerr << "背景图片目录不存在: " << actualBackgroundDir << std::endl;
-                return "";
-            }
-
-            // 查找所有图片文件
-            for (auto const& entry : std::filesystem::directory_iterator(actualBackgroundDir)) {
-                if (entry.is_regular_file()) {
-                    std::string extension = entry.path().extension().string();
-                    std::transform(extension.begin(), extension.end(), extension.begin(), ::tolower);
-
-                    if (extension == ".jpg" || extension == ".jpeg" || extension == ".png"
-                        || extension == ".gif") {
-                        imageFiles.push_back(entry.path().string());
-                    }
-                }
-            }
-
-            // 如果没有找到图片文件
-            if (imageFiles.empty()) {
-                std::cerr << "在背景目录中没有找到图片文件: " << actualBackgroundDir << std::endl;
-                return "";
-            }
-
-            // 随机选择一张图片
-            std::random_device              rd;
-            std::mt19937                    gen(rd());
-            std::uniform_int_distribution<> dis(0, static_cast<int>(imageFiles.size()) - 1);
-
-            return imageFiles[dis(gen)];
+        // 背景图片预缩放缓存
+        BackgroundVariantCache& backgroundVariants() { return m_variants; }
+
+        // 获取随机背景图片；key非空且为repo模式时，同一仓库总是得到同一张图片
+        std::string getRandomBackground(std::string const& backgroundDir = "",
+                                        std::string const& key           = "") {
+            BackgroundCatalogue& catalogue = backgroundCatalogue(backgroundDir);
+            std::string          image     = catalogue.pick(key);
+            if (image.empty())
+                std::cerr << "在背景目录中没有找到图片文件: " << catalogue.directory() << std::endl;
+            return image;
         }
 
         // 计算图标的CSS位置
@@ -169,8 +176,84 @@ namespace Yume {
         }
 
     private:
-        // 获取screenshot.js脚本路径
-        std::string getScriptPath() const { return m_style_dir + "/screenshot.js"; }
+        // 替换变量并处理循环、条件标签
+        std::string applyTemplate(std::string content,
+                                  std::map<std::string, std::string> const& variables) const {
+            // 替变量
+            for (auto const& [key, value] : variables)
+                content = replaceAll(content, "{{" + key + "}}", value);
+
+            // 处理循环标签
+            content = processLoops(content);
+
+            // 处理条件标签
+            content = processConditions(content);
+
+            return content;
+        }
+
+        bool renderHtml(std::string const& html, std::vector<std::string> const& paths,
+                        std::vector<OutputSpec> const& specs, int quality) {
+            std::string scriptPath;
+            if (!ensureScript(scriptPath)) return false;
+            if (specs.empty() || paths.size() != specs.size()) {
+                std::cerr << "截图输出规格为空或与输出路径不匹配" << std::endl;
+                return false;
+            }
+
+            RenderJob job{nextJobId(), html, std::filesystem::absolute(paths.front()).string(), quality};
+
+            nlohmann::json outputs = nlohmann::json::array();
+            for (size_t i = 0; i < specs.size(); ++i)
+                outputs.push_back(specs[i].toJson(std::filesystem::absolute(paths[i]).string()));
+
+            nlohmann::json payload;
+            payload["id"]      = job.id;
+            payload["baseDir"] = styleBaseDir();
+            payload["html"]    = job.html;
+            payload["output"]  = job.outputPath;
+            payload["quality"] = job.quality;
+            payload["outputs"] = std::move(outputs);
+
+            std::string command = CommandUtils::buildNodeCommand(scriptPath, {"-"});
+            std::cout << "[" << job.id << "] 执行截图命令: " << command << std::endl;
+            int result = CommandUtils::executeCommandWithInput(command, payload.dump());
+
+            if (result == 0) {
+                for (auto const& path : paths)
+                    std::cout << "[" << job.id << "] 截图成功！已保存到: " << path << std::endl;
+                return true;
+            }
+            std::cerr << "[" << job.id << "] 截图命令执行失败，返回代码: " << result << std::endl;
+            return false;
+        }
+
+        // 样式目录的规范化绝对路径，作为内存HTML中相对资源的基准
+        std::string styleBaseDir() const {
+            return std::filesystem::absolute(m_style_dir).lexically_normal().generic_string();
+        }
+
+        // 获取截图脚本路径：样式目录中的覆盖文件或写出的内置版本
+        bool ensureScript(std::string& scriptPath) {
+            scriptPath = m_theme.scriptPath(ThemeResources::kRenderer);
+            return !scriptPath.empty();
+        }
+
+        // 生成进程内唯一、跨进程可区分的任务ID
+        std::string static nextJobId() {
+            static std::atomic<unsigned long long> counter{0};
+#ifdef YUMECARD_PLATFORM_WINDOWS
+            auto pid = static_cast<unsigned long>(GetCurrentProcessId());
+#else
+            auto pid = static_cast<unsigned long>(getpid());
+#endif
+            auto now = std::chrono::duration_cast<std::chrono::milliseconds>(
+                           std::chrono::system_clock::now().time_since_epoch())
+                           .count();
+            std::ostringstream oss;
+            oss << "job-" << pid << "-" << now << "-" << counter.fetch_add(1);
+            return oss.str();
+        }
 
         // 替换字符串中的所有匹配项
         std::string replaceAll(std::string str, std::string const& from, std::string const& to) const {
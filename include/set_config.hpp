@@ -2,14 +2,15 @@
 
 #include <head.hpp>
 
+#include "repository_registry.hpp"
+
 namespace Yume {
     class Set_config {
     public:
-        // Corrected member initialization order
+        // 只在真正修改时写入；仓库的可变状态（lastsha等）保存在StateJournal中
         Set_config(nlohmann::json const& config, std::string config_path = "./config/config.json"):
-            m_config(config), m_config_path(std::move(config_path)) {
-            writeConfigToFile();
-        }
+            m_config(config), m_config_path(std::move(config_path)),
+            m_registry(RepositoryRegistry::fromConfig(m_config)) {}
 
         ~Set_config() = default;
 
@@ -19,75 +20,75 @@ namespace Yume {
             writeConfigToFile();
         }
 
-        void setLastSha(std::string const& owner, std::string const& repo, std::string const& sha) {
-            if (sha.empty()) return;
+        // 添加新的仓库，已存在时返回false
+        bool addRepository(std::string const& owner, std::string const& repo,
+                           std::string const& branch = "main") {
+            if (owner.empty() || repo.empty()) return false;
 
-            bool found = false;
-            if (m_config.contains("GitHub") && m_config["GitHub"].contains("repository")) {
-                auto& repository = m_config["GitHub"]["repository"];
-                for (auto& repos : repository) {
-                    if (repos["owner"].get<std::string>() == owner
-                        && repos["repo"].get<std::string>() == repo) {
-                        repos["lastsha"] = sha;
-                        found            = true;
-                        break;
-                    }
-                }
-            }
+            RepositoryEntry entry;
+            entry.owner  = owner;
+            entry.repo   = repo;
+            entry.branch = branch.empty() ? "main" : branch;
+            nlohmann::json json = entry.toJson();
+            if (!m_registry.add(std::move(entry))) return false;
 
-            if (found) writeConfigToFile();
+            auto& repository = m_config["GitHub"]["repository"];
+            if (!repository.is_array()) repository = nlohmann::json::array();
+            repository.push_back(std::move(json));
+            writeConfigToFile();
+            return true;
         }
 
-        // 添加新的仓库
-        void addRepository(std::string const& owner, std::string const& repo,
-                           std::string const& branch = "main") {
-            if (owner.empty() || repo.empty()) return;
-
-            bool exists = false;
-            if (m_config.contains("GitHub") && m_config["GitHub"].contains("repository")) {
-                auto& repository = m_config["GitHub"]["repository"];
-                for (auto& repos : repository) {
-                    if (repos["owner"].get<std::string>() == owner
-                        && repos["repo"].get<std::string>() == repo) {
-                        exists = true;
-                        break;
-                    }
-                }
-
-                if (!exists) {
-                    nlohmann::json newRepo = {
-                        {  "owner",  owner},
-                        {   "repo",   repo},
-                        { "branch", branch},
-                        {"lastsha",     ""}
-                    };
-                    repository.push_back(newRepo);
-                    writeConfigToFile();
-                }
+        // 批量添加仓库，全部加入后只写一次配置；返回实际新增的数量
+        size_t addRepositories(std::vector<RepositoryEntry> const& entries) {
+            auto& repository = m_config["GitHub"]["repository"];
+            if (!repository.is_array()) repository = nlohmann::json::array();
+            size_t added = 0;
+            for (auto const& entry : entries) {
+                if (!m_registry.add(entry)) continue;
+                repository.push_back(entry.toJson());
+                ++added;
             }
+            if (added > 0) writeConfigToFile();
+            return added;
         }
 
-    private:
-        void openConfigFile(std::ofstream& config_file) const {
-            config_file.open(m_config_path, std::ios::trunc);
+        [[nodiscard]] RepositoryRegistry const& repositories() const { return m_registry; }
+
+        // 清空配置中的仓库列表（已迁移到分片存储后调用）
+        void clearRepositories() {
+            m_config["GitHub"]["repository"] = nlohmann::json::array();
+            m_registry                       = RepositoryRegistry();
+            writeConfigToFile();
         }
 
+    private:
+        // 先写临时文件再重命名，写入中断时原配置保持完整
         void writeConfigToFile() const {
-            std::ofstream config_file;
-            openConfigFile(config_file);
-            if (config_file.is_open()) {
-                config_file << m_config.dump(4);
-                config_file.close();
-            } else {
+            std::string   tmpPath = m_config_path + ".tmp";
+            std::ofstream config_file(tmpPath, std::ios::trunc);
+            if (!config_file.is_open()) {
                 std::cerr << "无法打开配置文件进行写入。" << std::endl;
+                return;
+            }
+            config_file << m_config.dump(4);
+            config_file.close();
+            if (config_file.fail()) {
+                std::cerr << "写入配置文件失败: " << tmpPath << std::endl;
+                return;
             }
+
+            std::error_code ec;
+            std::filesystem::rename(tmpPath, m_config_path, ec);
+            if (ec) std::cerr << "无法替换配置文件: " << m_config_path << " - " << ec.message() << std::endl;
         }
 
     private:
         // Order of member variables should not strictly matter for -Wreorder if initialization list is
         // correct However, it's good practice to declare them in the order they are initialized or
         // logically grouped.
-        nlohmann::json m_config;      // Initialized first in the list
-        std::string    m_config_path; // Initialized second
+        nlohmann::json     m_config;      // Initialized first in the list
+        std::string        m_config_path; // Initialized second
+        RepositoryRegistry m_registry;    // 与 m_config["GitHub"]["repository"] 保持一致
     };
 };
@@ -0,0 +1,187 @@
+//
+// 二进制SHA：提交SHA以20字节保存和比较，只在读写JSON与显示时转换为40位十六进制
+// 十六进制编解码在支持SSE2的平台上每次处理16字节，其余平台使用逐字节查表
+// SeenShas记录仓库最近出现过的提交，强制推送或改写分支后不会重复推送已展示过的提交
+//
+
+#pragma once
+
+#include <array>
+#include <cstring>
+
+#include "head.hpp"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #include <emmintrin.h>
+    #define YUMECARD_HEX_SSE2 1
+#endif
+
+namespace Yume {
+
+    class HexCodec {
+    public:
+        // 把n个字节编码为2n个小写十六进制字符
+        void static encode(uint8_t const* bytes, size_t n, char* out) {
+            size_t i = 0;
+#ifdef YUMECARD_HEX_SSE2
+            __m128i const mask  = _mm_set1_epi8(0x0f);
+            __m128i const nine  = _mm_set1_epi8(9);
+            __m128i const zero  = _mm_set1_epi8('0');
+            __m128i const alpha = _mm_set1_epi8('a' - '0' - 10);
+            for (; i + 16 <= n; i += 16) {
+                __m128i in = _mm_loadu_si128(reinterpret_cast<__m128i const*>(bytes + i));
+                __m128i hi = _mm_and_si128(_mm_srli_epi16(in, 4), mask);
+                __m128i lo = _mm_and_si128(in, mask);
+                // 高低半字节交错后按顺序得到32个半字节
+                __m128i first  = _mm_unpacklo_epi8(hi, lo);
+                __m128i second = _mm_unpackhi_epi8(hi, lo);
+                first  = _mm_add_epi8(_mm_add_epi8(first, zero),
+                                      _mm_and_si128(_mm_cmpgt_epi8(first, nine), alpha));
+                second = _mm_add_epi8(_mm_add_epi8(second, zero),
+                                      _mm_and_si128(_mm_cmpgt_epi8(second, nine), alpha));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(out + 2 * i), first);
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(out + 2 * i + 16), second);
+            }
+#endif
+            static constexpr char kDigits[] = "0123456789abcdef";
+            for (; i < n; ++i) {
+                out[2 * i]     = kDigits[bytes[i] >> 4];
+                out[2 * i + 1] = kDigits[bytes[i] & 0x0f];
+            }
+        }
+
+        // 把2n个十六进制字符（大小写均可）解码为n个字节，含有其他字符时返回false
+        bool static decode(char const* hex, size_t n, uint8_t* out) {
+            size_t i = 0;
+#ifdef YUMECARD_HEX_SSE2
+            for (; i + 16 <= n; i += 16) {
+                auto    chars  = reinterpret_cast<__m128i const*>(hex + 2 * i);
+                __m128i first  = nibbles(_mm_loadu_si128(chars));
+                __m128i second = nibbles(_mm_loadu_si128(chars + 1));
+                // 无效字符对应的半字节被置为0xff
+                if (_mm_movemask_epi8(_mm_or_si128(first, second)) != 0) return false;
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i),
+                                 _mm_packus_epi16(combine(first), combine(second)));
+            }
+#endif
+            for (; i < n; ++i) {
+                int hi = nibble(hex[2 * i]);
+                int lo = nibble(hex[2 * i + 1]);
+                if (hi < 0 || lo < 0) return false;
+                out[i] = static_cast<uint8_t>(hi << 4 | lo);
+            }
+            return true;
+        }
+
+    private:
+        int static nibble(char c) {
+            if (c >= '0' && c <= '9') return c - '0';
+            if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+            if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+            return -1;
+        }
+
+#ifdef YUMECARD_HEX_SSE2
+        // 16个字符 -> 16个半字节值，无效字符为0xff
+        __m128i static nibbles(__m128i chars) {
+            __m128i digit   = _mm_sub_epi8(chars, _mm_set1_epi8('0'));
+            __m128i isDigit = _mm_and_si128(_mm_cmpgt_epi8(digit, _mm_set1_epi8(-1)),
+                                            _mm_cmplt_epi8(digit, _mm_set1_epi8(10)));
+            __m128i letter  = _mm_sub_epi8(_mm_or_si128(chars, _mm_set1_epi8(0x20)), _mm_set1_epi8('a'));
+            __m128i isAlpha = _mm_and_si128(_mm_cmpgt_epi8(letter, _mm_set1_epi8(-1)),
+                                            _mm_cmplt_epi8(letter, _mm_set1_epi8(6)));
+            __m128i alpha   = _mm_add_epi8(letter, _mm_set1_epi8(10));
+            __m128i value   = _mm_or_si128(_mm_and_si128(isDigit, digit), _mm_and_si128(isAlpha, alpha));
+            __m128i invalid = _mm_andnot_si128(_mm_or_si128(isDigit, isAlpha), _mm_set1_epi8(-1));
+            return _mm_or_si128(value, invalid);
+        }
+
+        // 每个16位通道中的(高半字节, 低半字节) -> 一个字节值
+        __m128i static combine(__m128i pairs) {
+            __m128i hi = _mm_slli_epi16(_mm_and_si128(pairs, _mm_set1_epi16(0x00ff)), 4);
+            __m128i lo = _mm_srli_epi16(pairs, 8);
+            return _mm_or_si128(hi, lo);
+        }
+#endif
+    };
+
+    struct ShaKey {
+        static constexpr size_t kBytes = 20;
+
+        std::array<uint8_t, kBytes> bytes{};
+
+        // 40位十六进制的SHA，长度不符或含有其他字符时返回std::nullopt
+        std::optional<ShaKey> static fromHex(std::string_view hex) {
+            ShaKey key;
+            if (hex.size() != kBytes * 2 || !HexCodec::decode(hex.data(), kBytes, key.bytes.data()))
+                return std::nullopt;
+            return key;
+        }
+
+        std::string hex() const {
+            std::string text(kBytes * 2, '\0');
+            HexCodec::encode(bytes.data(), kBytes, text.data());
+            return text;
+        }
+
+        auto operator<=>(ShaKey const&) const = default;
+
+        // SHA本身是均匀分布的，直接取前8个字节
+        struct Hash {
+            size_t operator()(ShaKey const& key) const {
+                uint64_t prefix;
+                std::memcpy(&prefix, key.bytes.data(), sizeof(prefix));
+                return static_cast<size_t>(prefix);
+            }
+        };
+    };
+
+    // 仓库最近出现过的kCapacity个提交，满后淘汰最早加入的；容量很小，线性查找比哈希表更省内存也足够快
+    class SeenShas {
+    public:
+        static constexpr size_t kCapacity = 64;
+
+        bool contains(ShaKey const& key) const {
+            return std::find(m_keys.begin(), m_keys.end(), key) != m_keys.end();
+        }
+
+        void insert(ShaKey const& key) {
+            if (contains(key)) return;
+            if (m_keys.size() < kCapacity) {
+                m_keys.push_back(key);
+                return;
+            }
+            m_keys[m_next] = key;
+            m_next         = (m_next + 1) % kCapacity;
+        }
+
+        size_t size() const { return m_keys.size(); }
+
+        bool empty() const { return m_keys.empty(); }
+
+        // 按加入顺序拼接的十六进制，保存在仓库状态中
+        std::string toHex() const {
+            std::string text(m_keys.size() * ShaKey::kBytes * 2, '\0');
+            char*       out = text.data();
+            for (size_t i = 0; i < m_keys.size(); ++i) {
+                auto const& key = m_keys[(m_next + i) % m_keys.size()];
+                HexCodec::encode(key.bytes.data(), ShaKey::kBytes, out);
+                out += ShaKey::kBytes * 2;
+            }
+            return text;
+        }
+
+        // 无效的片段被跳过
+        SeenShas static fromHex(std::string_view hex) {
+            SeenShas seen;
+            for (size_t pos = 0; pos + ShaKey::kBytes * 2 <= hex.size(); pos += ShaKey::kBytes * 2)
+                if (auto key = ShaKey::fromHex(hex.substr(pos, ShaKey::kBytes * 2))) seen.insert(*key);
+            return seen;
+        }
+
+    private:
+        std::vector<ShaKey> m_keys;
+        size_t              m_next = 0; // 已满时下一个被替换的位置，即最早加入的条目
+    };
+
+} // namespace Yume
@@ -0,0 +1,267 @@
+//
+// 多进程分片：每个工作进程在 <配置目录>/cluster/ 下持有一个租约文件并定期续约，
+// 各进程按存活的租约构建同一个一致性哈希环，只检查归属自己的仓库；
+// 租约过期（进程退出或失联）后，其仓库自动分给其余进程。各主机的时钟需要同步
+// 同一ID在整个进程生命周期内由 <ID>.lock 上的排他锁占用，同时启动的同名进程只有一个能加入
+//
+
+#pragma once
+
+#include <cerrno>
+#include <mutex>
+
+#include "consistent_hash_ring.hpp"
+#include "head.hpp"
+#include "state_journal.hpp"
+
+#ifndef YUMECARD_PLATFORM_WINDOWS
+    #include <fcntl.h>
+
+    #include <sys/file.h>
+#endif
+
+namespace Yume {
+
+    class ShardCoordinator {
+    public:
+        static constexpr int64_t kRenewInterval = 10; // 续约并重新读取成员的间隔（秒）
+        static constexpr int64_t kLeaseTtl      = 30; // 超过该时间未续约的租约视为失效
+        // 新成员加入时，原归属方立即让出仓库，新成员等待这段时间后才接手，两者不会同时检查同一仓库
+        static constexpr int64_t kHandoff = kRenewInterval * 3;
+
+        ShardCoordinator(std::string directory, std::string workerId):
+            m_directory(std::move(directory)), m_workerId(std::move(workerId)) {}
+
+        ~ShardCoordinator() { release(); }
+
+        ShardCoordinator(ShardCoordinator const&)            = delete;
+        ShardCoordinator& operator=(ShardCoordinator const&) = delete;
+
+        // 配置文件所在目录下的 cluster/
+        std::string static directoryFor(std::string const& configPath) {
+            return (std::filesystem::path(configPath).parent_path() / "cluster").string();
+        }
+
+        // 工作进程ID用作文件名，只允许字母、数字、'-' 和 '_'
+        bool static validId(std::string const& id) {
+            auto allowed = [](unsigned char c) { return std::isalnum(c) || c == '-' || c == '_'; };
+            return !id.empty() && id.size() <= 64 && std::all_of(id.begin(), id.end(), allowed);
+        }
+
+        std::string const& workerId() const { return m_workerId; }
+
+        // 锁定工作进程ID并写入自己的租约；ID被另一个进程锁定，或其他主机上的同名租约仍有效时失败
+        bool acquire() {
+            std::error_code ec;
+            std::filesystem::create_directories(m_directory, ec);
+            if (ec) {
+                std::cerr << "无法创建分片目录: " << m_directory << " - " << ec.message() << std::endl;
+                return false;
+            }
+            if (!lockId()) return false;
+
+            // 锁只在共享同一文件系统锁的主机之间有效，其他主机上的同名租约按时间判断
+            int64_t now = StateJournal::now();
+            if (auto lease = readLease(leasePath());
+                lease && lease->host != hostName() && now - lease->renewed <= kLeaseTtl) {
+                std::cerr << "工作进程ID " << m_workerId << " 正被 " << lease->host << " 上的进程 "
+                          << lease->pid << " 使用" << std::endl;
+                unlockId();
+                return false;
+            }
+
+            std::lock_guard lock(m_mutex);
+            m_since = now;
+            if (!writeLease(now)) {
+                unlockId();
+                return false;
+            }
+            m_renewed   = now;
+            m_lastRenew = now;
+            m_acquired  = true;
+            refreshLocked(now);
+            return true;
+        }
+
+        // 定期调用：按需续约并重新读取成员，自己负责的仓库发生变化时返回true
+        bool tick(int64_t now) {
+            std::lock_guard lock(m_mutex);
+            if (!m_acquired || now - m_lastRenew < kRenewInterval) return false;
+            m_lastRenew = now;
+            // 租约曾经失效（进程被挂起或存储不可用）时，其他进程可能已接手，需作为新成员重新加入
+            if (!validLocked(now)) m_since = now;
+            if (writeLease(now)) m_renewed = now;
+            return refreshLocked(now);
+        }
+
+        // 仓库是否由本进程检查；自己的租约续约失败时不再检查任何仓库，避免与接手的进程重复
+        bool owns(std::string_view key) const {
+            std::lock_guard lock(m_mutex);
+            if (!m_acquired || !validLocked(StateJournal::now())) return false;
+            return m_yielding.owner(key) == m_workerId && m_taking.owner(key) == m_workerId;
+        }
+
+        // 当前存活的成员
+        std::vector<std::string> members() const {
+            std::lock_guard lock(m_mutex);
+            return m_yielding.members();
+        }
+
+        // 正常退出时删除租约，其余进程在下一次读取成员时立即接手；锁文件保留，删除它会让等待中的进程锁住旧文件
+        void release() {
+            std::lock_guard lock(m_mutex);
+            if (!m_acquired) return;
+            m_acquired = false;
+            std::error_code ec;
+            std::filesystem::remove(leasePath(), ec);
+            unlockId();
+        }
+
+    private:
+        struct Lease {
+            std::string worker;
+            std::string host;
+            int64_t     pid     = 0;
+            int64_t     since   = 0; // 加入时间
+            int64_t     renewed = 0; // 最近一次续约时间
+        };
+
+        std::string        m_directory;
+        std::string        m_workerId;
+        mutable std::mutex m_mutex;
+        bool               m_acquired  = false;
+        int64_t            m_since     = 0;
+        int64_t            m_renewed   = 0;
+        int64_t            m_lastRenew = 0;
+        bool               m_valid     = false;
+        ConsistentHashRing m_yielding; // 包含所有存活成员：仓库归属他人时立即让出
+        ConsistentHashRing m_taking;   // 只包含加入超过kHandoff的成员：接手仓库前留出让出的时间
+#ifdef YUMECARD_PLATFORM_WINDOWS
+        HANDLE m_lock = INVALID_HANDLE_VALUE;
+#else
+        int m_lock = -1;
+#endif
+
+        std::string leasePath() const { return PathUtils::joinPath(m_directory, m_workerId + ".lease"); }
+
+        std::string lockPath() const { return PathUtils::joinPath(m_directory, m_workerId + ".lock"); }
+
+        // 租约文件续约时会被整体替换，锁放在单独的文件上；进程退出（包括崩溃）时由系统释放
+        bool lockId() {
+#ifdef YUMECARD_PLATFORM_WINDOWS
+            m_lock = CreateFileA(lockPath().c_str(), GENERIC_READ | GENERIC_WRITE, 0, nullptr,
+                                 OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+            bool busy = m_lock == INVALID_HANDLE_VALUE && GetLastError() == ERROR_SHARING_VIOLATION;
+            bool ok   = m_lock != INVALID_HANDLE_VALUE;
+#else
+            m_lock    = ::open(lockPath().c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0600);
+            bool busy = false;
+            if (m_lock >= 0 && flock(m_lock, LOCK_EX | LOCK_NB) != 0) {
+                busy = errno == EWOULDBLOCK;
+                unlockId();
+            }
+            bool ok = m_lock >= 0;
+#endif
+            if (busy) std::cerr << "工作进程ID " << m_workerId << " 正被另一个进程使用" << std::endl;
+            else if (!ok) std::cerr << "无法锁定工作进程ID: " << lockPath() << std::endl;
+            return ok;
+        }
+
+        void unlockId() {
+#ifdef YUMECARD_PLATFORM_WINDOWS
+            if (m_lock != INVALID_HANDLE_VALUE) CloseHandle(m_lock);
+            m_lock = INVALID_HANDLE_VALUE;
+#else
+            if (m_lock >= 0) ::close(m_lock);
+            m_lock = -1;
+#endif
+        }
+
+        // 留出一个续约间隔的余量，在其他进程认定租约过期之前先停止检查
+        bool validLocked(int64_t now) const { return now - m_renewed < kLeaseTtl - kRenewInterval; }
+
+        bool refreshLocked(int64_t now) {
+            std::vector<std::string> live, settled;
+            std::error_code          ec;
+            for (auto const& file : std::filesystem::directory_iterator(m_directory, ec)) {
+                if (file.path().extension() != ".lease") continue;
+                auto lease = readLease(file.path().string());
+                if (!lease || now - lease->renewed > kLeaseTtl) continue;
+                live.push_back(lease->worker);
+                if (now - lease->since >= kHandoff) settled.push_back(lease->worker);
+            }
+
+            ConsistentHashRing yielding(live), taking(settled);
+            bool               valid   = validLocked(now);
+            bool changed = !(yielding == m_yielding) || !(taking == m_taking) || valid != m_valid;
+            m_yielding   = std::move(yielding);
+            m_taking     = std::move(taking);
+            m_valid      = valid;
+            return changed;
+        }
+
+        std::optional<Lease> static readLease(std::string const& path) {
+            std::ifstream in(path);
+            if (!in.is_open()) return std::nullopt;
+            try {
+                nlohmann::json json = nlohmann::json::parse(in);
+                Lease          lease;
+                lease.worker  = json.value("worker", "");
+                lease.host    = json.value("host", "");
+                lease.pid     = json.value("pid", int64_t{0});
+                lease.since   = json.value("since", int64_t{0});
+                lease.renewed = json.value("renewed", int64_t{0});
+                if (lease.worker.empty()) return std::nullopt;
+                return lease;
+            } catch (nlohmann::json::exception const&) {
+                return std::nullopt; // 正在被替换或已损坏，按不存在处理
+            }
+        }
+
+        // 先写临时文件再重命名，读取方不会看到写了一半的租约
+        bool writeLease(int64_t now) const {
+            nlohmann::json json = {
+                { "worker",  m_workerId},
+                {   "host",  hostName()},
+                {    "pid", processId()},
+                {  "since",     m_since},
+                {"renewed",         now}
+            };
+            std::string tmpPath = leasePath() + ".tmp";
+            {
+                std::ofstream out(tmpPath, std::ios::binary | std::ios::trunc);
+                if (!(out << json.dump())) {
+                    std::cerr << "无法写入租约: " << tmpPath << std::endl;
+                    return false;
+                }
+            }
+            std::error_code ec;
+            std::filesystem::rename(tmpPath, leasePath(), ec);
+            if (ec) {
+                std::cerr << "无法更新租约: " << leasePath() << " - " << ec.message() << std::endl;
+                return false;
+            }
+            return true;
+        }
+
+        std::string static hostName() {
+            char name[256] = {};
+#ifdef YUMECARD_PLATFORM_WINDOWS
+            DWORD size = sizeof(name);
+            if (!GetComputerNameA(name, &size)) return "unknown";
+#else
+            if (gethostname(name, sizeof(name) - 1) != 0) return "unknown";
+#endif
+            return name;
+        }
+
+        int64_t static processId() {
+#ifdef YUMECARD_PLATFORM_WINDOWS
+            return static_cast<int64_t>(GetCurrentProcessId());
+#else
+            return static_cast<int64_t>(getpid());
+#endif
+        }
+    };
+
+} // namespace Yume
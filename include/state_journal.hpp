@@ -0,0 +1,422 @@
+//
+// 订阅状态日志：每个仓库的可变状态（最新SHA、检查时间、ETag）与只读的config.json分开保存
+// 更新只追加一行到日志，按批次fsync；日志过长时写快照（临时文件+重命名）并清空日志
+// 每条记录包含该仓库的完整状态，重放时后者覆盖前者，崩溃后重复重放也不会出错
+//
+
+#pragma once
+
+#include <functional>
+#include <mutex>
+
+#include "head.hpp"
+#include "platform_utils.hpp"
+#include "sha_key.hpp"
+
+#ifndef YUMECARD_PLATFORM_WINDOWS
+    #include <fcntl.h>
+#endif
+
+namespace Yume {
+
+    struct RepoState {
+        std::string lastSha;
+        std::string etag;
+        int64_t     lastChecked = 0; // 最近一次成功检查的时间（Unix秒）
+        int64_t     lastUpdated = 0; // 最近一次发现新提交的时间（Unix秒）
+        int64_t     lastCommit  = 0; // 已见到的最新提交的提交时间（Unix秒）
+        double      meanGap     = 0; // 提交间隔的指数平滑均值（秒），0表示尚无数据
+        int64_t     nextCheck   = 0; // 下一次应检查的时间（Unix秒），0表示立即检查
+        SeenShas    seen;            // 最近推送过的提交
+
+        nlohmann::json toJson() const {
+            nlohmann::json json = {
+                {"lastsha",     lastSha},
+                {   "etag",        etag},
+                {"checked", lastChecked},
+                {"updated", lastUpdated},
+                { "commit",  lastCommit},
+                {    "gap",     meanGap},
+                {   "next",   nextCheck}
+            };
+            if (!seen.empty()) json["seen"] = seen.toHex();
+            return json;
+        }
+
+        RepoState static fromJson(nlohmann::json const& json) {
+            RepoState state;
+            state.lastSha     = json.value("lastsha", "");
+            state.etag        = json.value("etag", "");
+            state.lastChecked = json.value("checked", int64_t{0});
+            state.lastUpdated = json.value("updated", int64_t{0});
+            state.lastCommit  = json.value("commit", int64_t{0});
+            state.meanGap     = json.value("gap", 0.0);
+            state.nextCheck   = json.value("next", int64_t{0});
+            if (auto it = json.find("seen"); it != json.end() && it->is_string())
+                state.seen = SeenShas::fromHex(it->get_ref<std::string const&>());
+            return state;
+        }
+    };
+
+    class StateJournal {
+    public:
+        // 累积这么多条未同步记录，或距上次同步超过kSyncInterval时执行fsync
+        static constexpr size_t kSyncBatch         = 64;
+        static constexpr auto   kSyncInterval      = std::chrono::seconds(1);
+        static constexpr size_t kMinCompactRecords = 1024;
+
+        // readOnly时只加载状态，不打开日志写入，也不截断损坏的尾部（供list等命令在监控运行时使用）
+        explicit StateJournal(std::string directory, bool readOnly = false):
+            m_directory(std::move(directory)), m_readOnly(readOnly) {
+            loadSnapshot();
+            replayJournal();
+            if (!m_readOnly) openJournal();
+        }
+
+        ~StateJournal() {
+            std::lock_guard lock(m_mutex);
+            closeJournalLocked();
+        }
+
+        StateJournal(StateJournal const&)            = delete;
+        StateJournal& operator=(StateJournal const&) = delete;
+
+        // 配置文件所在目录下的 state/；分片模式下每个工作进程使用 state/workers/<ID>/
+        std::string static directoryFor(std::string const& configPath,
+                                        std::string const& workerId = "") {
+            auto directory = std::filesystem::path(configPath).parent_path() / "state";
+            if (!workerId.empty()) directory = directory / "workers" / workerId;
+            return directory.string();
+        }
+
+        // 单进程与各工作进程的全部状态目录
+        std::vector<std::string> static directoriesFor(std::string const& configPath) {
+            std::vector<std::string> directories{directoryFor(configPath)};
+            std::error_code          ec;
+            auto                     workers = std::filesystem::path(directories.front()) / "workers";
+            for (auto const& entry : std::filesystem::directory_iterator(workers, ec))
+                if (entry.is_directory()) directories.push_back(entry.path().string());
+            return directories;
+        }
+
+        // 只读合并所有状态目录（exclude除外），每个仓库取最近检查或更新的记录
+        std::map<std::string, RepoState> static collect(std::string const& configPath,
+                                                        std::string const& exclude = "") {
+            std::map<std::string, RepoState> merged;
+            for (auto const& directory : directoriesFor(configPath)) {
+                if (!exclude.empty() && std::filesystem::path(directory) == exclude) continue;
+                StateJournal journal(directory, true);
+                for (auto& [key, state] : journal.all()) {
+                    auto it = merged.find(key);
+                    if (it == merged.end() || freshness(state) > freshness(it->second))
+                        merged[key] = state;
+                }
+            }
+            return merged;
+        }
+
+        int64_t static freshness(RepoState const& state) {
+            return std::max(state.lastChecked, state.lastUpdated);
+        }
+
+        std::string const& directory() const { return m_directory; }
+
+        std::string static key(std::string const& owner, std::string const& repo) {
+            return owner + "/" + repo;
+        }
+
+        std::optional<RepoState> get(std::string const& key) const {
+            std::lock_guard lock(m_mutex);
+            auto            it = m_states.find(key);
+            if (it == m_states.end()) return std::nullopt;
+            return it->second;
+        }
+
+        std::string lastSha(std::string const& key) const {
+            std::lock_guard lock(m_mutex);
+            auto            it = m_states.find(key);
+            return it != m_states.end() ? it->second.lastSha : "";
+        }
+
+        std::map<std::string, RepoState> all() const {
+            std::lock_guard lock(m_mutex);
+            return m_states;
+        }
+
+        // 写入完整状态并追加一条日志记录
+        void put(std::string const& key, RepoState const& state) {
+            std::lock_guard lock(m_mutex);
+            m_states[key] = state;
+            appendLocked(key, state);
+        }
+
+        // 记录新的最新SHA
+        void setLastSha(std::string const& key, std::string const& sha) {
+            std::lock_guard lock(m_mutex);
+            RepoState&      state = m_states[key];
+            state.lastSha         = sha;
+            state.lastUpdated     = now();
+            appendLocked(key, state);
+        }
+
+        // 记录一次成功检查（没有新提交时也会调用）
+        void markChecked(std::string const& key, std::string const& etag = "") {
+            std::lock_guard lock(m_mutex);
+            RepoState&      state = m_states[key];
+            state.lastChecked     = now();
+            if (!etag.empty()) state.etag = etag;
+            appendLocked(key, state);
+        }
+
+        // 在锁内修改一个仓库的状态并追加记录
+        void update(std::string const& key, std::function<void(RepoState&)> const& mutate) {
+            std::lock_guard lock(m_mutex);
+            RepoState&      state = m_states[key];
+            mutate(state);
+            appendLocked(key, state);
+        }
+
+        // 仅在没有记录时写入，用于从旧版config.json中的lastsha迁移
+        bool seed(std::string const& key, std::string const& sha) {
+            if (sha.empty()) return false;
+            std::lock_guard lock(m_mutex);
+            if (m_states.count(key)) return false;
+            RepoState& state = m_states[key];
+            state.lastSha    = sha;
+            appendLocked(key, state);
+            return true;
+        }
+
+        // 当前Unix秒
+        int64_t static now() {
+            return std::chrono::duration_cast<std::chrono::seconds>(
+                       std::chrono::system_clock::now().time_since_epoch())
+                .count();
+        }
+
+        // 立即把已追加的记录落盘
+        void sync() {
+            std::lock_guard lock(m_mutex);
+            syncLocked();
+        }
+
+        // 监控停止（或运行中定期保存）时留下的工作，下次启动时优先处理
+        struct Queue {
+            std::vector<std::string> repos;                           // 尚未完成检查的仓库，按到期顺序
+            nlohmann::json           cards = nlohmann::json::array(); // 已记录为最新、尚未生成的卡片
+        };
+
+        // 两者都为空时删除文件
+        bool saveQueue(std::vector<std::string> const& keys,
+                       nlohmann::json const&           cards = nlohmann::json::array()) {
+            if (m_readOnly) return false;
+            std::lock_guard lock(m_mutex);
+            if (keys.empty() && cards.empty()) {
+                std::error_code ec;
+                std::filesystem::remove(queuePath(), ec);
+                return true;
+            }
+            nlohmann::json queue;
+            queue["saved"] = now();
+            queue["repos"] = keys;
+            if (!cards.empty()) queue["cards"] = cards;
+            return writeDurably(queuePath(), queue.dump(2));
+        }
+
+        // 读取并删除上次保存的检查队列，每个队列只会被恢复一次
+        Queue takeQueue() {
+            std::lock_guard lock(m_mutex);
+            Queue           saved;
+            std::ifstream   in(queuePath());
+            if (!in.is_open()) return saved;
+            try {
+                nlohmann::json queue = nlohmann::json::parse(in);
+                for (auto const& key : queue.value("repos", nlohmann::json::array()))
+                    if (key.is_string()) saved.repos.push_back(key.get<std::string>());
+                if (auto cards = queue.find("cards"); cards != queue.end() && cards->is_array())
+                    saved.cards = std::move(*cards);
+            } catch (nlohmann::json::exception const& e) {
+                std::cerr << "检查队列文件损坏，已忽略: " << queuePath() << " - " << e.what() << std::endl;
+            }
+            in.close();
+            if (!m_readOnly) {
+                std::error_code ec;
+                std::filesystem::remove(queuePath(), ec);
+            }
+            return saved;
+        }
+
+        // 写出快照并清空日志
+        bool compact() {
+            std::lock_guard lock(m_mutex);
+            return compactLocked();
+        }
+
+    private:
+        std::string                           m_directory;
+        bool                                  m_readOnly;
+        mutable std::mutex                    m_mutex;
+        std::map<std::string, RepoState>      m_states;
+        std::FILE*                            m_journal        = nullptr;
+        size_t                                m_journalRecords = 0; // 日志中的记录数，用于决定何时压缩
+        size_t                                m_unsynced       = 0;
+        std::chrono::steady_clock::time_point m_lastSync       = std::chrono::steady_clock::now();
+
+        std::string snapshotPath() const { return PathUtils::joinPath(m_directory, "snapshot.json"); }
+        std::string journalPath() const { return PathUtils::joinPath(m_directory, "journal.log"); }
+        std::string queuePath() const { return PathUtils::joinPath(m_directory, "queue.json"); }
+
+        void loadSnapshot() {
+            std::ifstream in(snapshotPath());
+            if (!in.is_open()) return;
+            try {
+                nlohmann::json snapshot = nlohmann::json::parse(in);
+                if (snapshot.contains("repositories") && snapshot["repositories"].is_object())
+                    for (auto const& [key, value] : snapshot["repositories"].items())
+                        m_states[key] = RepoState::fromJson(value);
+            } catch (nlohmann::json::exception const& e) {
+                std::cerr << "状态快照损坏，将只使用日志: " << snapshotPath() << " - " << e.what()
+                          << std::endl;
+            }
+        }
+
+        // 逐行重放；遇到无法解析的行（崩溃时写了一半）即停止，并在可写模式下截掉该尾部
+        void replayJournal() {
+            std::ifstream in(journalPath(), std::ios::binary);
+            if (!in.is_open()) return;
+
+            std::string line;
+            uintmax_t   validLength = 0;
+            bool        truncated   = false;
+            while (std::getline(in, line)) {
+                if (in.eof()) { // 最后一行没有换行符，说明写入未完成
+                    truncated = true;
+                    break;
+                }
+                try {
+                    nlohmann::json record = nlohmann::json::parse(line);
+                    m_states[record.at("repo").get<std::string>()] = RepoState::fromJson(record);
+                } catch (nlohmann::json::exception const&) {
+                    truncated = true;
+                    break;
+                }
+                validLength += line.size() + 1;
+                ++m_journalRecords;
+            }
+            in.close();
+
+            if (truncated && !m_readOnly) {
+                std::error_code ec;
+                std::filesystem::resize_file(journalPath(), validLength, ec);
+                std::cerr << "状态日志尾部不完整，已截断到 " << validLength << " 字节" << std::endl;
+            }
+        }
+
+        void openJournal() {
+            std::error_code ec;
+            std::filesystem::create_directories(m_directory, ec);
+            if (ec) {
+                std::cerr << "无法创建状态目录: " << m_directory << " - " << ec.message() << std::endl;
+                return;
+            }
+            m_journal = std::fopen(journalPath().c_str(), "ab");
+            if (!m_journal) std::cerr << "无法打开状态日志: " << journalPath() << std::endl;
+        }
+
+        void closeJournalLocked() {
+            if (!m_journal) return;
+            syncLocked();
+            std::fclose(m_journal);
+            m_journal = nullptr;
+        }
+
+        void appendLocked(std::string const& key, RepoState const& state) {
+            if (!m_journal) return;
+            nlohmann::json record = state.toJson();
+            record["repo"]        = key;
+            std::string line      = record.dump() + "\n";
+            // 整行一次写入，进程崩溃时已写入的记录仍在页缓存中
+            std::fwrite(line.data(), 1, line.size(), m_journal);
+            std::fflush(m_journal);
+            ++m_journalRecords;
+            ++m_unsynced;
+
+            auto sinceSync = std::chrono::steady_clock::now() - m_lastSync;
+            if (m_unsynced >= kSyncBatch || sinceSync >= kSyncInterval) syncLocked();
+            if (m_journalRecords >= std::max(kMinCompactRecords, m_states.size() * 4)) compactLocked();
+        }
+
+        void syncLocked() {
+            if (!m_journal || m_unsynced == 0) return;
+            std::fflush(m_journal);
+            syncFile(m_journal);
+            m_unsynced = 0;
+            m_lastSync = std::chrono::steady_clock::now();
+        }
+
+        void static syncFile(std::FILE* file) {
+#ifdef YUMECARD_PLATFORM_WINDOWS
+            _commit(_fileno(file));
+#else
+            fsync(fileno(file));
+#endif
+        }
+
+        // 快照先写临时文件并fsync，重命名后再清空日志；任一步骤中断，重启时快照+日志仍能恢复完整状态
+        bool compactLocked() {
+            if (m_readOnly) return false;
+
+            nlohmann::json snapshot;
+            snapshot["version"]      = 1;
+            snapshot["repositories"] = nlohmann::json::object();
+            for (auto const& [key, state] : m_states) snapshot["repositories"][key] = state.toJson();
+
+            if (!writeDurably(snapshotPath(), snapshot.dump(2))) return false;
+
+            if (m_journal) std::fclose(m_journal);
+            m_journal        = std::fopen(journalPath().c_str(), "wb");
+            m_journalRecords = 0;
+            m_unsynced       = 0;
+            if (!m_journal) std::cerr << "无法重新打开状态日志: " << journalPath() << std::endl;
+            return true;
+        }
+
+        // 先写临时文件并fsync，再重命名替换目标文件
+        bool writeDurably(std::string const& path, std::string const& content) const {
+            std::string tmpPath = path + ".tmp";
+            std::FILE*  out     = std::fopen(tmpPath.c_str(), "wb");
+            if (!out) {
+                std::cerr << "无法写入状态文件: " << tmpPath << std::endl;
+                return false;
+            }
+            bool ok = std::fwrite(content.data(), 1, content.size(), out) == content.size();
+            ok      = std::fflush(out) == 0 && ok;
+            syncFile(out);
+            std::fclose(out);
+            if (!ok) {
+                std::cerr << "写入状态文件失败: " << tmpPath << std::endl;
+                return false;
+            }
+
+            std::error_code ec;
+            std::filesystem::rename(tmpPath, path, ec);
+            if (ec) {
+                std::cerr << "无法替换状态文件: " << path << " - " << ec.message() << std::endl;
+                return false;
+            }
+            syncDirectory();
+            return true;
+        }
+
+        // 让重命名本身也落盘
+        void syncDirectory() const {
+#ifndef YUMECARD_PLATFORM_WINDOWS
+            int fd = open(m_directory.c_str(), O_RDONLY);
+            if (fd < 0) return;
+            fsync(fd);
+            close(fd);
+#endif
+        }
+    };
+
+} // namespace Yume
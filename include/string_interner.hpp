@@ -0,0 +1,72 @@
+//
+// 字符串驻留：作者、头像链接、仓库名等在提交之间大量重复的字段只保存一份，
+// 文本放在只增不减的内存块中，返回的视图在进程生命周期内有效，内容相同则地址相同
+//
+
+#pragma once
+
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <unordered_set>
+
+#include "head.hpp"
+
+namespace Yume {
+
+    class StringInterner {
+    public:
+        static constexpr size_t kBlockSize = 64 * 1024;
+        static constexpr size_t kMaxBytes  = 64 * 1024 * 1024; // 超过后不再驻留新的字符串
+        static constexpr size_t kMaxLength = 1024;             // 更长的文本不值得驻留
+
+        // 进程内共用的驻留表
+        StringInterner static& global() {
+            static StringInterner interner;
+            return interner;
+        }
+
+        // 返回驻留的视图；文本过长或驻留表已满时返回std::nullopt，调用方自行保存
+        std::optional<std::string_view> intern(std::string_view text) {
+            if (text.empty()) return std::string_view{};
+            if (text.size() > kMaxLength) return std::nullopt;
+            {
+                std::shared_lock lock(m_mutex);
+                if (auto it = m_index.find(text); it != m_index.end()) return *it;
+            }
+            std::unique_lock lock(m_mutex);
+            if (auto it = m_index.find(text); it != m_index.end()) return *it;
+            if (m_bytes + text.size() > kMaxBytes) return std::nullopt;
+
+            if (m_blocks.empty() || m_used + text.size() > kBlockSize) {
+                m_blocks.push_back(std::make_unique_for_overwrite<char[]>(kBlockSize));
+                m_used = 0;
+            }
+            char* data = m_blocks.back().get() + m_used;
+            std::memcpy(data, text.data(), text.size());
+            m_used += text.size();
+            m_bytes += text.size();
+            return *m_index.emplace(data, text.size()).first;
+        }
+
+        // 驻留的字符串数与占用的字节数
+        size_t size() const {
+            std::shared_lock lock(m_mutex);
+            return m_index.size();
+        }
+
+        size_t bytes() const {
+            std::shared_lock lock(m_mutex);
+            return m_bytes;
+        }
+
+    private:
+        mutable std::shared_mutex            m_mutex;
+        std::unordered_set<std::string_view> m_index; // 视图指向m_blocks中的文本
+        std::vector<std::unique_ptr<char[]>> m_blocks;
+        size_t                               m_used  = 0; // 最后一块已使用的字节数
+        size_t                               m_bytes = 0;
+    };
+
+} // namespace Yume
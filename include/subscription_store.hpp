@@ -0,0 +1,478 @@
+//
+// 分片订阅存储：仓库按 owner/repo 的哈希分散到 subscriptions/shards/NN.json，
+// 另有按哈希排序的紧凑二进制索引 index.bin（mmap映射）。启动与list只读取索引，
+// 索引记录每个仓库在分片文件中的位置，读取详情时只解析这一条，内存占用不随订阅数量线性增长
+//
+
+#pragma once
+
+#include <cstring>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <set>
+
+#include "head.hpp"
+#include "platform_utils.hpp"
+#include "repository_registry.hpp"
+
+#ifndef YUMECARD_PLATFORM_WINDOWS
+    #include <fcntl.h>
+
+    #include <sys/mman.h>
+#endif
+
+namespace Yume {
+
+    class SubscriptionStore {
+    public:
+        static constexpr uint32_t kDefaultShards = 64;
+        static constexpr size_t   kCachedShards  = 8; // 条目位置失效时整体解析的分片
+
+        explicit SubscriptionStore(std::string directory): m_directory(std::move(directory)) {
+            refresh();
+        }
+
+        ~SubscriptionStore() { unmap(); }
+
+        SubscriptionStore(SubscriptionStore const&)            = delete;
+        SubscriptionStore& operator=(SubscriptionStore const&) = delete;
+
+        // 配置文件所在目录下的 subscriptions/
+        std::string static directoryFor(std::string const& configPath) {
+            return (std::filesystem::path(configPath).parent_path() / "subscriptions").string();
+        }
+
+        // 按仓库列表重建整个存储（迁移或批量导入时使用）
+        bool static build(std::string const& directory, std::vector<RepositoryEntry> const& entries,
+                          uint32_t shardCount = kDefaultShards) {
+            std::vector<std::vector<nlohmann::json>> shards(shardCount);
+            std::vector<IndexEntry>                  index;
+            index.reserve(entries.size());
+            for (auto const& entry : entries) {
+                std::string key   = entry.fullName();
+                uint64_t    hash  = hashKey(key);
+                auto        shard = static_cast<uint16_t>(hash % shardCount);
+                shards[shard].push_back(entry.toJson());
+                index.push_back({hash, shard, std::move(key)});
+            }
+
+            std::error_code ec;
+            std::filesystem::create_directories(PathUtils::joinPath(directory, "shards"), ec);
+            if (ec) {
+                std::cerr << "无法创建订阅存储目录: " << directory << " - " << ec.message() << std::endl;
+                return false;
+            }
+            std::map<std::string, EntrySpan> spans;
+            for (uint32_t i = 0; i < shardCount; ++i)
+                if (!writeShard(directory, i, shards[i], spans)) return false;
+            return writeIndex(directory, std::move(index), spans, shardCount);
+        }
+
+        // 重新映射索引；文件未变化时什么也不做。返回索引是否可用
+        bool refresh() {
+            std::lock_guard lock(m_mutex);
+            std::error_code ec;
+            std::string     path      = indexPath(m_directory);
+            auto            size      = std::filesystem::file_size(path, ec);
+            auto            writeTime = ec ? std::filesystem::file_time_type{}
+                                           : std::filesystem::last_write_time(path, ec);
+            if (ec) {
+                unmap();
+                return false;
+            }
+            if (m_data && size == m_size && writeTime == m_writeTime) return true;
+
+            unmap();
+            m_shardCache.clear();
+            m_shardOrder.clear();
+            if (!mapIndex(path, size)) return false;
+            m_writeTime = writeTime;
+            return true;
+        }
+
+        // refresh()可能在其他线程上重新映射索引，读取映射内容都要持有m_mutex
+        bool available() const {
+            std::lock_guard lock(m_mutex);
+            return m_data != nullptr;
+        }
+
+        size_t size() const {
+            std::lock_guard lock(m_mutex);
+            return count();
+        }
+
+        // 全部仓库的 owner/repo（按哈希顺序），只读取索引，不解析任何分片
+        std::vector<std::string> keys() const {
+            std::lock_guard          lock(m_mutex);
+            std::vector<std::string> result;
+            result.reserve(count());
+            for (size_t i = 0; i < count(); ++i) result.emplace_back(keyAt(i));
+            return result;
+        }
+
+        bool contains(std::string_view owner, std::string_view repo) const {
+            std::lock_guard lock(m_mutex);
+            return findRecord(owner, repo) != nullptr;
+        }
+
+        // 读取仓库详情：按索引中的位置只解析这一条，分片在此之后被改写时才解析整个分片
+        std::optional<RepositoryEntry> find(std::string_view owner, std::string_view repo) {
+            std::lock_guard    lock(m_mutex);
+            IndexRecord const* record = findRecord(owner, repo);
+            if (!record) return std::nullopt;
+            if (auto entry = readEntry(*record, owner, repo)) return entry;
+            RepositoryRegistry const& shard = loadShard(record->shard);
+            auto const*               entry = shard.find(owner, repo);
+            return entry ? std::optional<RepositoryEntry>(*entry) : std::nullopt;
+        }
+
+        // 逐个分片遍历全部仓库，同一时刻只解析一个分片
+        void forEach(std::function<void(RepositoryEntry const&)> const& visit) const {
+            uint32_t shardCount = 0;
+            {
+                std::lock_guard lock(m_mutex);
+                shardCount = m_header ? m_header->shards : 0;
+            }
+            for (uint32_t i = 0; i < shardCount; ++i) {
+                RepositoryRegistry shard(readShard(m_directory, i));
+                for (auto const& entry : shard.entries()) visit(entry);
+            }
+        }
+
+        // 添加一个仓库：只重写其所在分片与索引，已存在时返回false
+        bool add(RepositoryEntry const& entry) { return addAll({entry}) == 1; }
+
+        // 批量添加：每个涉及的分片与索引各重写一次，返回实际新增的数量
+        size_t addAll(std::vector<RepositoryEntry> const& entries) {
+            size_t added = addLocked(entries);
+            if (added > 0) refresh(); // 索引大小改变，重新映射
+            return added;
+        }
+
+    private:
+        size_t addLocked(std::vector<RepositoryEntry> const& entries) {
+            std::lock_guard lock(m_mutex);
+            if (!m_header) return 0;
+
+            std::vector<IndexEntry>          index;
+            std::map<std::string, EntrySpan> spans; // 未改写的分片沿用原来的位置
+            index.reserve(count() + entries.size());
+            for (size_t i = 0; i < count(); ++i) {
+                IndexRecord const& record = m_records[i];
+                index.push_back({record.hash, record.shard, std::string(keyAt(i))});
+                spans.emplace(index.back().key, EntrySpan{record.entryOffset, record.entryLength});
+            }
+
+            std::map<uint16_t, std::vector<nlohmann::json>> shards;
+            std::set<std::string>                           seen;
+            for (auto const& entry : entries) {
+                std::string key = entry.fullName();
+                if (findRecord(entry.owner, entry.repo) || !seen.insert(key).second) continue;
+                uint64_t hash  = hashKey(key);
+                auto     shard = static_cast<uint16_t>(hash % m_header->shards);
+                auto     it    = shards.find(shard);
+                if (it == shards.end()) {
+                    nlohmann::json items = readShard(m_directory, shard);
+                    it = shards.emplace(shard, std::vector<nlohmann::json>(items.begin(), items.end()))
+                             .first;
+                }
+                it->second.push_back(entry.toJson());
+                index.push_back({hash, shard, std::move(key)});
+            }
+            if (seen.empty()) return 0;
+
+            // 先写分片再写索引：中途失败时索引里没有的仓库只是多余的分片条目，
+            // 原有条目的位置对不上时按整个分片查找，都不影响查找
+            for (auto const& [shard, items] : shards)
+                if (!writeShard(m_directory, shard, items, spans)) return 0;
+            return writeIndex(m_directory, std::move(index), spans, m_header->shards) ? seen.size() : 0;
+        }
+
+        size_t count() const { return m_header ? m_header->count : 0; }
+
+        std::string_view keyAt(size_t i) const {
+            IndexRecord const& record = m_records[i];
+            return {m_keys + record.keyOffset, record.keyLength};
+        }
+
+        // index.bin: 头部 + 按(哈希, 键)排序的定长记录 + 键字符串池；按本机字节序存储
+        // 记录中的条目位置是该仓库在分片文件中的字节范围，分片按每行一个条目写入
+        struct IndexHeader {
+            char     magic[4];
+            uint32_t version;
+            uint32_t count;
+            uint32_t shards;
+        };
+
+        struct IndexRecord {
+            uint64_t hash;
+            uint32_t keyOffset;
+            uint16_t keyLength;
+            uint16_t shard;
+            uint32_t entryOffset;
+            uint32_t entryLength; // 为0时位置未知
+        };
+
+        static_assert(sizeof(IndexHeader) == 16 && sizeof(IndexRecord) == 24);
+
+        struct IndexEntry {
+            uint64_t    hash;
+            uint16_t    shard;
+            std::string key;
+        };
+
+        struct EntrySpan {
+            uint32_t offset = 0;
+            uint32_t length = 0;
+        };
+
+        static constexpr char     kMagic[4]      = {'Y', 'C', 'S', 'I'};
+        static constexpr uint32_t kVersion       = 2;
+        static constexpr uint32_t kLegacyVersion = 1; // 没有条目位置，映射时按分片重建
+
+        std::string                     m_directory;
+        mutable std::mutex              m_mutex;
+        std::filesystem::file_time_type m_writeTime{};
+        char const*                     m_data    = nullptr;
+        size_t                          m_size    = 0;
+        IndexHeader const*              m_header  = nullptr;
+        IndexRecord const*              m_records = nullptr;
+        char const*                     m_keys    = nullptr;
+#ifdef YUMECARD_PLATFORM_WINDOWS
+        std::vector<char> m_buffer; // 没有mmap时整体读入，索引本身很小
+#endif
+
+        std::map<uint16_t, RepositoryRegistry> m_shardCache;
+        std::deque<uint16_t>                   m_shardOrder;
+
+        std::string static indexPath(std::string const& directory) {
+            return PathUtils::joinPath(directory, "index.bin");
+        }
+
+        std::string static shardPath(std::string const& directory, uint32_t shard) {
+            std::ostringstream name;
+            name << "shards/" << std::setw(2) << std::setfill('0') << shard << ".json";
+            return PathUtils::joinPath(directory, name.str());
+        }
+
+        uint64_t static mix(uint64_t hash, std::string_view text) {
+            for (unsigned char c : text) {
+                hash ^= c;
+                hash *= 1099511628211ULL;
+            }
+            return hash;
+        }
+
+        uint64_t static hashKey(std::string_view key) { return mix(14695981039346656037ULL, key); }
+
+        uint64_t static hashKey(std::string_view owner, std::string_view repo) {
+            return mix(mix(mix(14695981039346656037ULL, owner), "/"), repo);
+        }
+
+        IndexRecord const* findRecord(std::string_view owner, std::string_view repo) const {
+            if (!m_header) return nullptr;
+            uint64_t           hash  = hashKey(owner, repo);
+            IndexRecord const* end   = m_records + m_header->count;
+            IndexRecord const* first = std::lower_bound(m_records, end, hash,
+                                                        [](IndexRecord const& record, uint64_t h) {
+                                                            return record.hash < h;
+                                                        });
+            for (IndexRecord const* it = first; it != end && it->hash == hash; ++it) {
+                std::string_view key(m_keys + it->keyOffset, it->keyLength);
+                if (key.size() == owner.size() + 1 + repo.size() && key.starts_with(owner)
+                    && key[owner.size()] == '/' && key.ends_with(repo))
+                    return it;
+            }
+            return nullptr;
+        }
+
+        nlohmann::json static readShard(std::string const& directory, uint32_t shard) {
+            std::ifstream in(shardPath(directory, shard));
+            if (!in.is_open()) return nlohmann::json::array();
+            try {
+                nlohmann::json items = nlohmann::json::parse(in);
+                return items.is_array() ? items : nlohmann::json::array();
+            } catch (nlohmann::json::parse_error const& e) {
+                std::cerr << "订阅分片解析失败: " << shardPath(directory, shard) << " - " << e.what()
+                          << std::endl;
+                return nlohmann::json::array();
+            }
+        }
+
+        // 每行一个条目写入分片，同时记下每个仓库所在的字节范围（同一仓库出现多次时以第一条为准）
+        bool static writeShard(std::string const& directory, uint32_t shard,
+                               std::vector<nlohmann::json> const& items,
+                               std::map<std::string, EntrySpan>&  spans) {
+            std::string                      content = "[\n";
+            std::map<std::string, EntrySpan> written;
+            for (size_t i = 0; i < items.size(); ++i) {
+                std::string line = items[i].dump();
+                EntrySpan   span{static_cast<uint32_t>(content.size()),
+                               static_cast<uint32_t>(line.size())};
+                if (auto entry = RepositoryEntry::fromJson(items[i]))
+                    written.try_emplace(entry->fullName(), span);
+                content += line;
+                content += i + 1 < items.size() ? ",\n" : "\n";
+            }
+            content += "]\n";
+            if (!writeFileAtomic(shardPath(directory, shard), content)) return false;
+            for (auto& [key, span] : written) spans[key] = span;
+            return true;
+        }
+
+        // 按索引记录的位置读取一个条目；分片已被改写、位置对不上时返回std::nullopt
+        std::optional<RepositoryEntry> readEntry(IndexRecord const& record, std::string_view owner,
+                                                 std::string_view repo) const {
+            if (record.entryLength == 0) return std::nullopt;
+            std::ifstream in(shardPath(m_directory, record.shard), std::ios::binary);
+            std::string   text(record.entryLength, '\0');
+            if (!in.is_open() || !in.seekg(record.entryOffset)
+                || !in.read(text.data(), static_cast<std::streamsize>(text.size())))
+                return std::nullopt;
+            auto json = nlohmann::json::parse(text, nullptr, false);
+            auto entry = RepositoryEntry::fromJson(json);
+            if (!entry || entry->owner != owner || entry->repo != repo) return std::nullopt;
+            return entry;
+        }
+
+        RepositoryRegistry const& loadShard(uint16_t shard) {
+            auto it = m_shardCache.find(shard);
+            if (it != m_shardCache.end()) return it->second;
+
+            while (m_shardOrder.size() >= kCachedShards) {
+                m_shardCache.erase(m_shardOrder.front());
+                m_shardOrder.pop_front();
+            }
+            m_shardOrder.push_back(shard);
+            RepositoryRegistry registry(readShard(m_directory, shard));
+            return m_shardCache.emplace(shard, std::move(registry)).first->second;
+        }
+
+        bool static writeIndex(std::string const& directory, std::vector<IndexEntry> index,
+                               std::map<std::string, EntrySpan> const& spans, uint32_t shardCount) {
+            std::sort(index.begin(), index.end(), [](IndexEntry const& a, IndexEntry const& b) {
+                return a.hash != b.hash ? a.hash < b.hash : a.key < b.key;
+            });
+
+            IndexHeader header{};
+            std::memcpy(header.magic, kMagic, sizeof(kMagic));
+            header.version = kVersion;
+            header.count   = static_cast<uint32_t>(index.size());
+            header.shards  = shardCount;
+
+            std::string content(reinterpret_cast<char const*>(&header), sizeof(header));
+            std::string keys;
+            for (auto const& entry : index) {
+                auto        span = spans.find(entry.key);
+                IndexRecord record{entry.hash,
+                                   static_cast<uint32_t>(keys.size()),
+                                   static_cast<uint16_t>(entry.key.size()),
+                                   entry.shard,
+                                   span != spans.end() ? span->second.offset : 0,
+                                   span != spans.end() ? span->second.length : 0};
+                content.append(reinterpret_cast<char const*>(&record), sizeof(record));
+                keys += entry.key;
+            }
+            content += keys;
+            return writeFileAtomic(indexPath(directory), content);
+        }
+
+        bool mapIndex(std::string const& path, size_t size) {
+            if (size < sizeof(IndexHeader)) return false;
+#ifdef YUMECARD_PLATFORM_WINDOWS
+            std::ifstream in(path, std::ios::binary);
+            if (!in.is_open()) return false;
+            m_buffer.resize(size);
+            in.read(m_buffer.data(), static_cast<std::streamsize>(size));
+            if (static_cast<size_t>(in.gcount()) != size) return false;
+            m_data = m_buffer.data();
+#else
+            int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+            if (fd < 0) return false;
+            void* data = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+            close(fd);
+            if (data == MAP_FAILED) return false;
+            m_data = static_cast<char const*>(data);
+#endif
+            m_size   = size;
+            m_header = reinterpret_cast<IndexHeader const*>(m_data);
+            if (std::memcmp(m_header->magic, kMagic, sizeof(kMagic)) == 0
+                && m_header->version == kLegacyVersion && m_header->shards > 0) {
+                uint32_t shards = m_header->shards;
+                unmap();
+                return upgradeIndex(path, shards);
+            }
+            size_t recordsEnd =
+                sizeof(IndexHeader) + static_cast<size_t>(m_header->count) * sizeof(IndexRecord);
+            if (std::memcmp(m_header->magic, kMagic, sizeof(kMagic)) != 0 || m_header->version != kVersion
+                || m_header->shards == 0 || m_header->shards > 0x10000 || recordsEnd > size) {
+                std::cerr << "订阅索引格式无效: " << path << std::endl;
+                unmap();
+                return false;
+            }
+            m_records = reinterpret_cast<IndexRecord const*>(m_data + sizeof(IndexHeader));
+            m_keys    = m_data + recordsEnd;
+
+            // 索引可能被截断或手工修改：逐条检查一次，之后的查找不再检查边界
+            size_t keysSize = size - recordsEnd;
+            for (size_t i = 0; i < m_header->count; ++i) {
+                IndexRecord const& record = m_records[i];
+                bool sorted = i == 0 || m_records[i - 1].hash <= record.hash;
+                if (static_cast<size_t>(record.keyOffset) + record.keyLength > keysSize
+                    || record.shard >= m_header->shards || !sorted) {
+                    std::cerr << "订阅索引格式无效: " << path << " (第 " << i + 1 << " 条记录)" << std::endl;
+                    unmap();
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        // 旧版索引没有条目位置：读取全部分片重建一次，分片数不变，仓库所在的分片也不变
+        bool upgradeIndex(std::string const& path, uint32_t shardCount) {
+            std::cout << "正在升级订阅索引: " << path << std::endl;
+            std::vector<RepositoryEntry> entries;
+            for (uint32_t i = 0; i < shardCount; ++i) {
+                RepositoryRegistry shard(readShard(m_directory, i));
+                entries.insert(entries.end(), shard.entries().begin(), shard.entries().end());
+            }
+            if (!build(m_directory, entries, shardCount)) return false;
+            std::error_code ec;
+            auto            size = std::filesystem::file_size(path, ec);
+            return !ec && mapIndex(path, size);
+        }
+
+        void unmap() {
+#ifdef YUMECARD_PLATFORM_WINDOWS
+            m_buffer.clear();
+#else
+            if (m_data) munmap(const_cast<char*>(m_data), m_size);
+#endif
+            m_data    = nullptr;
+            m_size    = 0;
+            m_header  = nullptr;
+            m_records = nullptr;
+            m_keys    = nullptr;
+        }
+
+        bool static writeFileAtomic(std::string const& path, std::string const& content) {
+            std::string   tmpPath = path + ".tmp";
+            std::ofstream out(tmpPath, std::ios::binary | std::ios::trunc);
+            if (!out.is_open()) {
+                std::cerr << "无法写入文件: " << tmpPath << std::endl;
+                return false;
+            }
+            out << content;
+            out.close();
+            std::error_code ec;
+            std::filesystem::rename(tmpPath, path, ec);
+            if (ec) {
+                std::cerr << "无法替换文件: " << path << " - " << ec.message() << std::endl;
+                return false;
+            }
+            return true;
+        }
+    };
+
+} // namespace Yume
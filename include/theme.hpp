@@ -0,0 +1,194 @@
+//
+// 主题资源：默认模板、样式与脚本在构建时嵌入程序，样式目录中存在同名文件时以磁盘文件为准
+// 来源在构造时确定一次，内容首次使用时读取并缓存，渲染过程中不再访问文件系统
+//
+
+#pragma once
+
+#include <mutex>
+#include <set>
+
+#include "embedded_theme.hpp"
+#include "head.hpp"
+#include "platform_utils.hpp"
+
+namespace Yume {
+
+    class ThemeResources {
+    public:
+        static constexpr char const* kTemplate   = "index.html";
+        static constexpr char const* kStylesheet = "custom.css";
+        static constexpr char const* kRenderer   = "screenshot.js";
+        static constexpr char const* kPrescaler  = "prescale.js";
+
+        explicit ThemeResources(std::string style_dir = "./Style"): m_style_dir(std::move(style_dir)) {
+            for (auto const& file : embedded::kFiles) {
+                std::error_code ec;
+                std::string     name(file.name);
+                if (std::filesystem::is_regular_file(PathUtils::joinPath(m_style_dir, name), ec))
+                    m_overrides.insert(name);
+            }
+        }
+
+        ThemeResources(ThemeResources const&)            = delete;
+        ThemeResources& operator=(ThemeResources const&) = delete;
+
+        // 内嵌的默认版本，不存在时返回空
+        std::string_view static embeddedFile(std::string_view name) {
+            for (auto const& file : embedded::kFiles)
+                if (file.name == name) return {reinterpret_cast<char const*>(file.data), file.size};
+            return {};
+        }
+
+        // 样式目录中是否存在覆盖文件（构造时确定）
+        bool isOverridden(std::string const& name) const { return m_overrides.count(name) > 0; }
+
+        // 文件内容：覆盖文件或内嵌版本
+        std::string const& content(std::string const& name) {
+            std::lock_guard lock(m_mutex);
+            return contentLocked(name);
+        }
+
+        // 模板内容，custom.css已内联为<style>，页面加载时少一次文件请求
+        std::string const& templateHtml() {
+            std::lock_guard lock(m_mutex);
+            if (!m_templateHtml) m_templateHtml = inlineStylesheet(contentLocked(kTemplate),
+                                                                   contentLocked(kStylesheet));
+            return *m_templateHtml;
+        }
+
+        // 交给node执行的脚本路径：优先使用覆盖文件，否则把内嵌版本写到 <style>/.yumecard/ 下
+        // 脚本仍位于样式目录之内，node的模块查找路径与原先一致；每个进程只写出一次
+        std::string scriptPath(std::string const& name) {
+            if (isOverridden(name)) return PathUtils::joinPath(m_style_dir, name);
+
+            std::lock_guard lock(m_mutex);
+            auto            it = m_scripts.find(name);
+            if (it != m_scripts.end()) return it->second;
+
+            std::string_view data = embeddedFile(name);
+            if (data.empty()) {
+                std::cerr << "主题中不存在脚本: " << name << std::endl;
+                return "";
+            }
+            std::string path = PathUtils::joinPath(materializeDir(), name);
+            if (!materialize(path, data)) return "";
+            m_scripts[name] = path;
+            return path;
+        }
+
+        // 把内嵌的默认主题导出到样式目录，便于在此基础上修改；已存在的文件不覆盖
+        bool exportDefaults() {
+            bool ok = true;
+            for (auto const& file : embedded::kFiles) {
+                std::string name = std::string(file.name);
+                std::string path = PathUtils::joinPath(m_style_dir, name);
+                if (FileSystemUtils::fileExists(path)) {
+                    std::cout << "已存在，跳过: " << path << std::endl;
+                    continue;
+                }
+                if (!writeFileAtomic(path, {reinterpret_cast<char const*>(file.data), file.size})) {
+                    ok = false;
+                    continue;
+                }
+                std::cout << "已导出: " << path << std::endl;
+            }
+            return ok;
+        }
+
+    private:
+        std::string                        m_style_dir;
+        std::set<std::string>              m_overrides;
+        std::mutex                         m_mutex;
+        std::map<std::string, std::string> m_contents;
+        std::map<std::string, std::string> m_scripts;
+        std::optional<std::string>         m_templateHtml;
+
+        std::string materializeDir() const { return PathUtils::joinPath(m_style_dir, ".yumecard"); }
+
+        std::string const& contentLocked(std::string const& name) {
+            auto it = m_contents.find(name);
+            if (it != m_contents.end()) return it->second;
+
+            std::string data;
+            if (isOverridden(name)) {
+                std::string   path = PathUtils::joinPath(m_style_dir, name);
+                std::ifstream in(path, std::ios::binary);
+                if (in.is_open()) {
+                    std::stringstream buffer;
+                    buffer << in.rdbuf();
+                    data = buffer.str();
+                } else {
+                    std::cerr << "无法读取主题文件，改用内置版本: " << path << std::endl;
+                    data = std::string(embeddedFile(name));
+                }
+            } else {
+                data = std::string(embeddedFile(name));
+            }
+            return m_contents.emplace(name, std::move(data)).first->second;
+        }
+
+        // 把 <link href="custom.css" ...> 替换为内联样式，相对url()仍以样式目录为基准解析
+        std::string static inlineStylesheet(std::string html, std::string const& css) {
+            size_t pos = 0;
+            while ((pos = html.find("<link", pos)) != std::string::npos) {
+                size_t end = html.find('>', pos);
+                if (end == std::string::npos) break;
+                std::string_view tag(html.data() + pos, end - pos + 1);
+                if (tag.find("href=\"custom.css\"") == std::string_view::npos) {
+                    pos = end;
+                    continue;
+                }
+                std::string replacement = "<style>\n" + css + "\n</style>";
+                html.replace(pos, end - pos + 1, replacement);
+                pos += replacement.size();
+            }
+            return html;
+        }
+
+        // 内容一致时不重写，避免多个进程同时启动时互相覆盖正在执行的脚本
+        bool materialize(std::string const& path, std::string_view data) const {
+            std::ifstream in(path, std::ios::binary);
+            if (in.is_open()) {
+                std::stringstream buffer;
+                buffer << in.rdbuf();
+                if (buffer.str() == data) return true;
+                in.close();
+            }
+
+            std::error_code ec;
+            std::filesystem::create_directories(materializeDir(), ec);
+            if (ec) {
+                std::cerr << "无法创建目录: " << materializeDir() << " - " << ec.message() << std::endl;
+                return false;
+            }
+            return writeFileAtomic(path, data);
+        }
+
+        // 临时文件名带进程号，并发写出时各自重命名，结果相同
+        bool static writeFileAtomic(std::string const& path, std::string_view data) {
+#ifdef YUMECARD_PLATFORM_WINDOWS
+            auto pid = static_cast<unsigned long>(GetCurrentProcessId());
+#else
+            auto pid = static_cast<unsigned long>(getpid());
+#endif
+            std::string   tmpPath = path + "." + std::to_string(pid) + ".tmp";
+            std::ofstream out(tmpPath, std::ios::binary | std::ios::trunc);
+            if (!out.is_open()) {
+                std::cerr << "无法写入文件: " << tmpPath << std::endl;
+                return false;
+            }
+            out.write(data.data(), static_cast<std::streamsize>(data.size()));
+            out.close();
+            std::error_code ec;
+            std::filesystem::rename(tmpPath, path, ec);
+            if (ec) {
+                std::cerr << "无法替换文件: " << path << " - " << ec.message() << std::endl;
+                std::filesystem::remove(tmpPath, ec);
+                return false;
+            }
+            return true;
+        }
+    };
+
+} // namespace Yume
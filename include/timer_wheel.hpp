@@ -0,0 +1,101 @@
+//
+// 分层时间轮：4层、每层64个槽，刻度为1秒，可覆盖约194天
+// 插入按到期时间落到对应层的槽中，O(1)；推进时低层槽逐个到期，高层槽在低层转完一圈时下放
+//
+
+#pragma once
+
+#include <array>
+
+#include "head.hpp"
+
+namespace Yume {
+
+    template <typename T>
+    class TimerWheel {
+    public:
+        static constexpr int     kLevels   = 4;
+        static constexpr int     kSlotBits = 6;
+        static constexpr int64_t kSlots    = int64_t{1} << kSlotBits;
+        static constexpr int64_t kSlotMask = kSlots - 1;
+        static constexpr int64_t kRange    = int64_t{1} << (kSlotBits * kLevels); // 可直接放入的最大间隔
+
+        explicit TimerWheel(int64_t now): m_now(now) {}
+
+        // 到期时间不晚于当前刻度的项在下一次advance时立即到期
+        void schedule(T item, int64_t deadline) {
+            ++m_size;
+            place({deadline, std::move(item)});
+        }
+
+        // 推进到now，按到期顺序把到期的项交给expire
+        template <typename Expire>
+        void advance(int64_t now, Expire&& expire) {
+            flushReady(expire);
+            while (m_now < now) {
+                ++m_now;
+                // 低层转完一圈时，从高到低下放上一层对应的槽
+                for (int level = kLevels - 1; level > 0; --level)
+                    if ((m_now & ((int64_t{1} << (kSlotBits * level)) - 1)) == 0) cascade(level);
+                auto& slot = m_wheels[0][m_now & kSlotMask];
+                if (!slot.empty()) {
+                    std::vector<Entry> due;
+                    due.swap(slot);
+                    for (auto& entry : due) m_ready.push_back(std::move(entry));
+                }
+                flushReady(expire);
+            }
+        }
+
+        size_t size() const { return m_size; }
+
+        bool empty() const { return m_size == 0; }
+
+        int64_t now() const { return m_now; }
+
+    private:
+        struct Entry {
+            int64_t deadline;
+            T       item;
+        };
+
+        int64_t                                                  m_now;
+        size_t                                                   m_size = 0;
+        std::array<std::array<std::vector<Entry>, kSlots>, kLevels> m_wheels;
+        std::vector<Entry>                                       m_ready;
+
+        void place(Entry entry) {
+            int64_t delta = entry.deadline - m_now;
+            if (delta <= 0) {
+                m_ready.push_back(std::move(entry));
+                return;
+            }
+            // 超出范围的先放在最高层最远的槽，下放时重新计算
+            int64_t target = delta < kRange ? entry.deadline : m_now + kRange - 1;
+            delta          = target - m_now;
+            int level      = 0;
+            while (level < kLevels - 1 && delta >= (int64_t{1} << (kSlotBits * (level + 1)))) ++level;
+            m_wheels[level][(target >> (kSlotBits * level)) & kSlotMask].push_back(std::move(entry));
+        }
+
+        void cascade(int level) {
+            auto& slot = m_wheels[level][(m_now >> (kSlotBits * level)) & kSlotMask];
+            if (slot.empty()) return;
+            std::vector<Entry> entries;
+            entries.swap(slot);
+            for (auto& entry : entries) place(std::move(entry));
+        }
+
+        template <typename Expire>
+        void flushReady(Expire& expire) {
+            if (m_ready.empty()) return;
+            std::vector<Entry> ready;
+            ready.swap(m_ready);
+            for (auto& entry : ready) {
+                --m_size;
+                expire(std::move(entry.item));
+            }
+        }
+    };
+
+} // namespace Yume
@@ -0,0 +1,129 @@
+//
+// 工作窃取线程池：每个线程有自己的任务队列，线程内提交的任务放在本队列尾部并优先执行（缓存友好），
+// 自己的队列空了再从其他线程队列的头部窃取，负载不均时不会有线程空等
+//
+
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+
+#include "head.hpp"
+
+namespace Yume {
+
+    class WorkStealingPool {
+    public:
+        using Task = std::function<void()>;
+
+        explicit WorkStealingPool(size_t threads) {
+            threads = std::max<size_t>(1, threads);
+            for (size_t i = 0; i < threads; ++i) m_queues.push_back(std::make_unique<Queue>());
+            for (size_t i = 0; i < threads; ++i) m_threads.emplace_back([this, i]() { run(i); });
+        }
+
+        // 执行完已提交的任务后退出
+        ~WorkStealingPool() {
+            {
+                std::lock_guard lock(m_sleepMutex);
+                m_stop = true;
+            }
+            m_wake.notify_all();
+            for (auto& thread : m_threads) thread.join();
+        }
+
+        WorkStealingPool(WorkStealingPool const&)            = delete;
+        WorkStealingPool& operator=(WorkStealingPool const&) = delete;
+
+        void submit(Task task) {
+            // 池内线程提交到自己的队列，外部线程轮流分配
+            size_t index = t_pool == this ? t_index : m_next.fetch_add(1) % m_queues.size();
+            {
+                // 计数与入队在同一把锁内完成，取走任务时的减计数不会先于这里的加计数
+                std::lock_guard sleepLock(m_sleepMutex);
+                std::lock_guard queueLock(m_queues[index]->mutex);
+                m_queues[index]->tasks.push_back(std::move(task));
+                ++m_queued;
+                ++m_pending;
+            }
+            m_wake.notify_one();
+        }
+
+        size_t threadCount() const { return m_threads.size(); }
+
+        // 尚未执行完的任务数
+        size_t pending() const {
+            std::lock_guard lock(m_sleepMutex);
+            return m_pending;
+        }
+
+    private:
+        struct Queue {
+            std::mutex       mutex;
+            std::deque<Task> tasks;
+        };
+
+        std::vector<std::unique_ptr<Queue>> m_queues;
+        std::vector<std::thread>            m_threads;
+        std::atomic<size_t>                 m_next{0};
+        mutable std::mutex                  m_sleepMutex;
+        std::condition_variable             m_wake;
+        size_t                              m_queued  = 0; // 在队列中等待的任务
+        size_t                              m_pending = 0; // 等待中与执行中的任务
+        bool                                m_stop    = false;
+
+        inline static thread_local WorkStealingPool* t_pool  = nullptr;
+        inline static thread_local size_t            t_index = 0;
+
+        // 先取自己队列的尾部，再从其他队列头部窃取
+        bool tryTake(size_t index, Task& task) {
+            {
+                Queue&          own = *m_queues[index];
+                std::lock_guard lock(own.mutex);
+                if (!own.tasks.empty()) {
+                    task = std::move(own.tasks.back());
+                    own.tasks.pop_back();
+                    return true;
+                }
+            }
+            for (size_t offset = 1; offset < m_queues.size(); ++offset) {
+                Queue&          victim = *m_queues[(index + offset) % m_queues.size()];
+                std::lock_guard lock(victim.mutex);
+                if (!victim.tasks.empty()) {
+                    task = std::move(victim.tasks.front());
+                    victim.tasks.pop_front();
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        void run(size_t index) {
+            t_pool  = this;
+            t_index = index;
+            for (;;) {
+                Task task;
+                if (tryTake(index, task)) {
+                    {
+                        std::lock_guard lock(m_sleepMutex);
+                        --m_queued;
+                    }
+                    try {
+                        task();
+                    } catch (std::exception const& e) {
+                        std::cerr << "后台任务异常: " << e.what() << std::endl;
+                    }
+                    std::lock_guard lock(m_sleepMutex);
+                    --m_pending;
+                    continue;
+                }
+                std::unique_lock lock(m_sleepMutex);
+                m_wake.wait(lock, [this]() { return m_stop || m_queued > 0; });
+                if (m_stop && m_queued == 0) return;
+            }
+        }
+    };
+
+} // namespace Yume
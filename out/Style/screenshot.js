@@ -2,20 +2,59 @@ const puppeteer = require('puppeteer');
 const fs = require('fs');
 const path = require('path');
 
+// 从标准输入读取完整内容
+function readStdin() {
+    return new Promise((resolve, reject) => {
+        const chunks = [];
+        process.stdin.on('data', chunk => chunks.push(chunk));
+        process.stdin.on('end', () => resolve(Buffer.concat(chunks).toString('utf8')));
+        process.stdin.on('error', reject);
+    });
+}
+
+// 转换为file:// URL
+function toFileUrl(filePath) {
+    return 'file:///' + path.resolve(filePath).replace(/\\/g, '/').replace(/^\/+/, '');
+}
+
+// 在<head>中插入<base>，使相对路径(custom.css、backgrounds/)以样式目录为基准解析
+function withBaseHref(html, baseUrl) {
+    const baseTag = `<base href="${baseUrl}">`;
+    const headPattern = /<head(\s[^>]*)?>/i;
+    if (headPattern.test(html)) return html.replace(headPattern, match => match + baseTag);
+    return baseTag + html;
+}
+
 (async () => {
     const htmlFilePath = process.argv[2];
-    const outputImagePath = process.argv[3] || 'screenshot.png';
+    let outputImagePath = process.argv[3] || 'screenshot.png';
 
     if (!htmlFilePath) {
-        console.error('错误：请提供HTML文件路径作为第一个参数。');
+        console.error('错误：请提供HTML文件路径作为第一个参数，或使用 - 从标准输入读取任务。');
         process.exit(1);
     }
 
-    const absoluteHtmlPath = path.resolve(htmlFilePath);
+    // "-" 表示从标准输入读取JSON任务: {id, baseDir, html, output, quality, outputs}
+    let job = null;
+    if (htmlFilePath === '-') {
+        try {
+            job = JSON.parse(await readStdin());
+        } catch (e) {
+            console.error(`错误：无法解析标准输入中的任务: ${e.message}`);
+            process.exit(1);
+        }
+        outputImagePath = job.output || outputImagePath;
+    }
 
-    if (!fs.existsSync(absoluteHtmlPath)) {
-        console.error(`错误：HTML文件未找到: ${absoluteHtmlPath}`);
-        process.exit(1);
+    const tag = job && job.id ? `[${job.id}] ` : '';
+
+    let absoluteHtmlPath = null;
+    if (!job) {
+        absoluteHtmlPath = path.resolve(htmlFilePath);
+        if (!fs.existsSync(absoluteHtmlPath)) {
+            console.error(`错误：HTML文件未找到: ${absoluteHtmlPath}`);
+            process.exit(1);
+        }
     }
 
     const browser = await puppeteer.launch({
@@ -24,9 +63,17 @@ const path = require('path');
     });
     const page = await browser.newPage();
 
-    const fileUrl = 'file:///' + absoluteHtmlPath.replace(/\\/g, '/');
-    console.log(`正在加载: ${fileUrl}`);
-    await page.goto(fileUrl, {waitUntil: 'networkidle0'});
+    if (job) {
+        // 先导航到样式目录以获得file://源，再直接注入内存中的HTML
+        const baseUrl = toFileUrl(job.baseDir || process.cwd()).replace(/\/?$/, '/');
+        console.log(`${tag}正在加载内存中的HTML，基准目录: ${baseUrl}`);
+        await page.goto(baseUrl, {waitUntil: 'domcontentloaded'}).catch(() => {});
+        await page.setContent(withBaseHref(job.html || '', baseUrl), {waitUntil: 'networkidle0'});
+    } else {
+        const fileUrl = toFileUrl(absoluteHtmlPath);
+        console.log(`正在加载: ${fileUrl}`);
+        await page.goto(fileUrl, {waitUntil: 'networkidle0'});
+    }
 
     // 等待字体加载完成
     await page.evaluate(() => document.fonts.ready);
@@ -80,7 +127,7 @@ const path = require('path');
     const finalWidth = Math.max(viewportWidth, minWidth);
     const finalHeight = Math.max(viewportHeight, minHeight);
 
-    console.log(`计算出的视口尺寸: 宽=${finalWidth}, 高=${finalHeight}`);
+    console.log(`${tag}计算出的视口尺寸: 宽=${finalWidth}, 高=${finalHeight}`);
 
     await page.setViewport({
         width: finalWidth,
@@ -90,7 +137,7 @@ const path = require('path');
     // 等待短暂延迟确保页面完全渲染
     await new Promise(resolve => setTimeout(resolve, 500));
 
-    console.log(`正在截图并保存到: ${outputImagePath}`);
+    console.log(`${tag}正在截图并保存到: ${outputImagePath}`);
     // 确保页面完全加载
     await page.evaluate(async () => {
         // 等待可能的动画完成
@@ -137,15 +184,39 @@ const path = require('path');
         height: boundingBox.height
     };
 
-    console.log(`最终截图区域: x=${clipBox.x}, y=${clipBox.y}, 宽=${clipBox.width}, 高=${clipBox.height}`);
+    console.log(`${tag}最终截图区域: x=${clipBox.x}, y=${clipBox.y}, 宽=${clipBox.width}, 高=${clipBox.height}`);
+
+    // 输出规格: [{path, scale, clip, format, quality}]
+    // clip 为 "card"（卡片区域，默认）、"page"（整页）或 {x, y, width, height}
+    // 所有规格共享同一次页面加载和布局，每多一个规格只多一次截图
+    const outputs = (job && Array.isArray(job.outputs) && job.outputs.length > 0)
+        ? job.outputs
+        : [{path: outputImagePath}];
+
+    for (const output of outputs) {
+        const format = ['png', 'jpeg', 'webp'].includes(output.format) ? output.format : 'png';
+        const options = {path: output.path, type: format};
+        if (format !== 'png') options.quality = Math.min(100, Math.max(1, output.quality || 90));
+
+        let region = clipBox;
+        if (output.clip === 'page') {
+            const size = await page.evaluate(() => ({
+                width: document.documentElement.scrollWidth,
+                height: document.documentElement.scrollHeight
+            }));
+            region = {x: 0, y: 0, width: size.width, height: size.height};
+        } else if (output.clip && typeof output.clip === 'object') {
+            region = output.clip;
+        }
 
-    // 仅截取卡片区域，确保所有内容都被包含
-    await page.screenshot({
-        path: outputImagePath,
-        clip: clipBox
-    });
+        // clip.scale 让Chromium按目标倍率重新光栅化，2x输出是真正的高分辨率而非放大
+        options.clip = {...region, scale: output.scale > 0 ? output.scale : 1};
+
+        console.log(`${tag}正在输出: ${output.path} (${format}, ${options.clip.scale}x)`);
+        await page.screenshot(options);
+    }
 
     await browser.close();
-    console.log('截图完成!');
+    console.log(`${tag}截图完成!`);
 })();
 
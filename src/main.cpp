@@ -1,8 +1,15 @@
-﻿#include "github_api.hpp"
+﻿#include <charconv>
+
+#include "asset_bundler.hpp"
+#include "control_socket.hpp"
+#include "github_api.hpp"
 #include "github_subscriber.hpp"
 #include "head.hpp"
+#include "history_store.hpp"
 #include "read_config.hpp" // Added for listRepositories
 #include "set_config.hpp"
+#include "state_journal.hpp"
+#include "subscription_store.hpp"
 #include "system_info.hpp" // Ensure system_info.hpp is included for Yume::SystemInfoManager
 #include "version.hpp"     // 包含版本信息
 
@@ -18,6 +25,7 @@ struct AppConfig {
     std::string configDir = "./config";
     std::string styleDir  = "./Style";
     std::string outputDir = "./Style";
+    std::string workerId; // 非空时monitor以分片模式运行
 
     std::string getConfigPath() const { return configDir + "/config.json"; }
 };
@@ -39,6 +47,7 @@ std::pair<AppConfig, std::vector<std::string>> parseArguments(int argc, char* ar
         if (arg == "--config" && i + 1 < argc) config.configDir = argv[++i];
         else if (arg == "--style" && i + 1 < argc) config.styleDir = argv[++i];
         else if (arg == "--output" && i + 1 < argc) config.outputDir = argv[++i];
+        else if (arg == "--worker" && i + 1 < argc) config.workerId = argv[++i];
         else if (arg == "--version") {
             printVersion();
             exit(0);
@@ -74,6 +83,7 @@ void printHelp() {
     std::cout << "  --config <路径>              - 指定配置文件目录 (默认: ./config)" << std::endl;
     std::cout << "  --style <路径>               - 指定样式文件目录 (默认: ./Style)" << std::endl;
     std::cout << "  --output <路径>              - 指定输出图像目录 (默认: ./Style)" << std::endl;
+    std::cout << "  --worker <ID>                - 以分片工作进程运行monitor，多个进程分担仓库" << std::endl;
     std::cout << "  --version                    - 显示版本信息" << std::endl;
     std::cout << "  --help                       - 显示此帮助信息" << std::endl;
     std::cout << std::endl;
@@ -83,7 +93,14 @@ void printHelp() {
     std::cout << "  monitor [interval]           - 开始监控所有仓库 (默认每10分钟)" << std::endl;
     std::cout << "  set-token <token>            - 设置GitHub API访问令牌" << std::endl;
     std::cout << "  list                         - 列出所有已订阅的仓库" << std::endl;
+    std::cout << "  status                       - 显示运行中的监控进程的检查状态" << std::endl;
+    std::cout << "  history <owner> <repo>       - 查询本地记录的提交历史，可加 --since <时间>" << std::endl;
+    std::cout << "  import <文件|->               - 批量导入仓库订阅，每行 owner/repo[@branch]" << std::endl;
+    std::cout << "  migrate-store                - 将订阅列表迁移到分片存储（适用于大量仓库）" << std::endl;
     std::cout << "  test-screenshot              - 使用测试数据生成提交卡片截图" << std::endl;
+    std::cout << "  prescale-backgrounds         - 预先生成按卡片尺寸缩放的背景图片" << std::endl;
+    std::cout << "  bundle-assets                - 下载模板引用的外部字体和图片并改写为本地引用" << std::endl;
+    std::cout << "  export-theme                 - 将内置的默认主题导出到样式目录以便修改" << std::endl;
     std::cout << "  system-info                  - 显示系统信息和兼容性检查" << std::endl;
     std::cout << "  diagnostic                   - 生成诊断报告" << std::endl;
     std::cout << "  version                      - 显示版本信息" << std::endl;
@@ -93,7 +110,9 @@ void printHelp() {
     std::cout << "  YumeCard add YumeYuka YumeCard main" << std::endl;
     std::cout << "  YumeCard --config ./myconfig check YumeYuka YumeCard" << std::endl;
     std::cout << "  YumeCard --style ./mystyle --output ./images monitor 30" << std::endl;
+    std::cout << "  YumeCard --worker node-1 monitor" << std::endl;
     std::cout << "  YumeCard set-token ghp_xxxxxxxxxxxx" << std::endl;
+    std::cout << "  YumeCard import repos.txt" << std::endl;
     std::cout << "  YumeCard --config ./config --style ./themes test-screenshot" << std::endl;
     std::cout << "  YumeCard --version" << std::endl;
     std::cout << "--------------------------------------" << std::endl;
@@ -125,12 +144,134 @@ bool setGitHubToken(std::string const& configPath, std::string const& token) {
     return true;
 }
 
+// 预缩放所有背景图片并清理过期的缓存版本
+bool prescaleBackgrounds(std::string const& configPath, Yume::ScreenshotManager& screenshotManager,
+                         std::string const& styleDir) {
+    Yume::ReadConfig readConfig(configPath);
+    auto&            variants = screenshotManager.backgroundVariants();
+    variants.setOptions(readConfig.getBackgroundScaleOptions());
+
+    auto images = screenshotManager.backgroundCatalogue(styleDir + "/backgrounds").images();
+    if (images.empty()) {
+        std::cout << "没有需要预缩放的背景图片" << std::endl;
+        return true;
+    }
+
+    auto   ready   = variants.ensureVariants(images);
+    size_t removed = variants.prune(images);
+    std::cout << "背景预缩放完成: " << ready.size() << "/" << images.size() << " 张可用，清理了 "
+              << removed << " 个过期缓存" << std::endl;
+    return ready.size() == images.size();
+}
+
+// 指定--worker时只询问该工作进程，否则询问单进程监控与分片模式下的全部工作进程
+std::vector<std::string> monitorSockets(AppConfig const& config) {
+    if (!config.workerId.empty())
+        return {Yume::ControlClient::pathFor(config.getConfigPath(), config.workerId)};
+    return Yume::ControlClient::pathsFor(config.getConfigPath());
+}
+
+// 监控进程运行时把命令交给它处理；没有监控进程在监听时返回std::nullopt
+// 分片模式下依次询问各工作进程，直到有进程接手（响应中没有local标记）
+std::optional<nlohmann::json> requestMonitor(AppConfig const& config, nlohmann::json const& request,
+                                             std::chrono::seconds timeout = std::chrono::seconds(30)) {
+    std::optional<nlohmann::json> local;
+    for (auto const& path : monitorSockets(config)) {
+        auto response = Yume::ControlClient::request(path, request, timeout);
+        if (!response) continue;
+        if (!response->value("local", false)) return response;
+        local = std::move(response);
+    }
+    return local;
+}
+
+// 向每个正在运行的监控进程发送同一个请求（list、status）
+std::vector<nlohmann::json> requestMonitors(AppConfig const& config, nlohmann::json const& request) {
+    std::vector<nlohmann::json> responses;
+    for (auto const& path : monitorSockets(config))
+        if (auto response = Yume::ControlClient::request(path, request, std::chrono::seconds(30)))
+            responses.push_back(std::move(*response));
+    return responses;
+}
+
+void printRepository(std::string const& name, std::string const& branch, std::string const& lastSha) {
+    std::cout << "仓库: " << name << std::endl;
+    std::cout << "分支: " << branch << std::endl;
+    std::cout << "最新SHA: " << (lastSha.empty() ? "无" : lastSha) << std::endl;
+}
+
+// 由运行中的监控进程列出仓库，状态取自其内存；分片模式下依次列出各工作进程负责的仓库。监控未运行时返回false
+bool listMonitorRepositories(AppConfig const& config) {
+    nlohmann::json request = {
+        {"command", "list"}
+    };
+    bool    listed = false;
+    int64_t now    = Yume::StateJournal::now();
+    for (auto const& response : requestMonitors(config, request)) {
+        if (!response.value("ok", false)) continue;
+        listed             = true;
+        std::string worker = response.value("worker", "");
+        auto const& repos  = response["repos"];
+        if (worker.empty()) std::cout << "已订阅的仓库列表（来自运行中的监控进程）:" << std::endl;
+        else std::cout << "工作进程 " << worker << " 负责的仓库（" << repos.size() << " 个）:" << std::endl;
+        std::cout << "--------------------------------------" << std::endl;
+        for (auto const& repo : repos) {
+            printRepository(repo.value("name", ""), repo.value("branch", ""), repo.value("lastSha", ""));
+            int64_t next = repo.value("next", int64_t{0});
+            if (next > now) std::cout << "下一次检查: 约 " << (next - now + 59) / 60 << " 分钟后" << std::endl;
+            else std::cout << "下一次检查: 已到期" << std::endl;
+            std::cout << "--------------------------------------" << std::endl;
+        }
+    }
+    return listed;
+}
+
+// 显示运行中的监控进程的调度状态；分片模式下逐个显示各工作进程
+bool showMonitorStatus(AppConfig const& config) {
+    nlohmann::json request = {
+        {"command", "status"}
+    };
+    auto responses = requestMonitors(config, request);
+    if (responses.empty()) {
+        std::cout << "监控未运行" << std::endl;
+        return false;
+    }
+    bool ok = true;
+    for (auto const& status : responses) {
+        if (!status.value("ok", false)) {
+            std::cerr << "错误: " << status.value("error", "未知错误") << std::endl;
+            ok = false;
+            continue;
+        }
+        std::string worker = status.value("worker", "");
+        std::cout << "监控运行中" << (worker.empty() ? "" : "（工作进程 " + worker + "）") << "，已运行 "
+                  << status.value("uptime", int64_t{0}) / 60 << " 分钟" << std::endl;
+        if (status.contains("members")) {
+            std::string members;
+            for (auto const& member : status["members"])
+                members += (members.empty() ? "" : ", ") + member.get<std::string>();
+            std::cout << "分片成员: " << members << std::endl;
+        }
+        std::cout << "已安排检查的仓库: " << status.value("scheduled", 0) << std::endl;
+        std::cout << "正在检查: " << status.value("checking", 0) << "，等待准入: " << status.value("backlog", 0)
+                  << std::endl;
+        std::cout << "流水线在途: " << status.value("inFlight", 0) << "，等待截图: " << status.value("render", 0)
+                  << "，合并中的卡片: " << status.value("coalescing", 0) << std::endl;
+        std::cout << "驻留的作者、头像与仓库名: " << status.value("interned", 0) << " 个（"
+                  << status.value("internedBytes", 0) / 1024 << " KB）" << std::endl;
+    }
+    return ok;
+}
+
 // 列出所有已订阅的仓库
 void listRepositories(std::string const& configPath) {
-    Yume::ReadConfig readConfig(configPath);
-    auto             repositories = readConfig.getAllRepositories();
+    Yume::ReadConfig        readConfig(configPath);
+    auto const&             repositories = readConfig.getAllRepositories();
+    Yume::SubscriptionStore store(Yume::SubscriptionStore::directoryFor(configPath));
+    // 只读合并单进程与各分片工作进程的状态，监控进程可能正在写入
+    auto states = Yume::StateJournal::collect(configPath);
 
-    if (repositories.empty()) {
+    if (repositories.empty() && store.size() == 0) {
         std::cout << "尚未订阅任何仓库" << std::endl;
         return;
     }
@@ -138,23 +279,243 @@ void listRepositories(std::string const& configPath) {
     std::cout << "已订阅的仓库列表:" << std::endl;
     std::cout << "--------------------------------------" << std::endl;
 
-    for (auto const& repo : repositories) {
-        std::string owner    = repo["owner"].get<std::string>();
-        std::string repoName = repo["repo"].get<std::string>();
-        std::string branch   = repo["branch"].get<std::string>();
-        std::string lastSha  = repo.contains("lastsha") ? repo["lastsha"].get<std::string>() : "无";
+    auto print = [&states](Yume::RepositoryEntry const& repo) {
+        auto        it      = states.find(Yume::StateJournal::key(repo.owner, repo.repo));
+        std::string lastSha = it != states.end() ? it->second.lastSha : "";
+        if (lastSha.empty()) lastSha = repo.legacyLastSha;
 
-        std::cout << "仓库: " << owner << "/" << repoName << std::endl;
-        std::cout << "分支: " << branch << std::endl;
-        std::cout << "最新SHA: " << lastSha << std::endl;
+        printRepository(repo.fullName(), repo.branch, lastSha);
         std::cout << "--------------------------------------" << std::endl;
+    };
+
+    for (auto const& repo : repositories) print(repo);
+    // 分片存储逐个分片读取，不会一次性载入全部仓库
+    store.forEach([&](Yume::RepositoryEntry const& repo) {
+        if (!readConfig.repositories().contains(repo.owner, repo.repo)) print(repo);
+    });
+}
+
+// 把config.json中的仓库列表（连同已有的分片存储）写入分片存储，再清空配置中的列表
+bool migrateSubscriptionStore(std::string const& configPath) {
+    nlohmann::json config;
+    std::ifstream  config_in(configPath);
+    if (!config_in.is_open()) {
+        std::cerr << "无法打开配置文件: " << configPath << std::endl;
+        return false;
+    }
+    config_in >> config;
+    config_in.close();
+
+    Yume::Set_config        setConfig(config, configPath);
+    std::string             directory = Yume::SubscriptionStore::directoryFor(configPath);
+    Yume::RepositoryRegistry merged   = setConfig.repositories();
+    {
+        Yume::SubscriptionStore existing(directory);
+        existing.forEach([&merged](Yume::RepositoryEntry const& entry) { merged.add(entry); });
+    }
+
+    // 先写好存储再清空配置；中途失败时配置中的列表仍然有效
+    if (!Yume::SubscriptionStore::build(directory, merged.entries())) return false;
+    size_t moved = setConfig.repositories().size();
+    if (moved > 0) setConfig.clearRepositories();
+
+    std::cout << "已将 " << moved << " 个仓库迁移到分片存储，共 " << merged.size() << " 个仓库: " << directory
+              << std::endl;
+    return true;
+}
+
+// 批量导入订阅：每行 owner/repo[@branch]，空行与#开头的行忽略
+// 先并发验证所有仓库并取得最新SHA，再一次性写入配置（或分片存储）和状态日志
+bool importRepositories(std::string const& configPath, std::string const& source) {
+    std::ifstream file;
+    if (source != "-") {
+        file.open(source);
+        if (!file.is_open()) {
+            std::cerr << "无法打开导入文件: " << source << std::endl;
+            return false;
+        }
     }
+    std::istream& in = source == "-" ? std::cin : file;
+
+    nlohmann::json config;
+    std::ifstream  config_in(configPath);
+    if (!config_in.is_open()) {
+        std::cerr << "无法打开配置文件: " << configPath << std::endl;
+        return false;
+    }
+    config_in >> config;
+    config_in.close();
+
+    Yume::Set_config        setConfig(config, configPath);
+    Yume::SubscriptionStore store(Yume::SubscriptionStore::directoryFor(configPath));
+    Yume::RepositoryRegistry candidates;
+    size_t                   invalid = 0, existing = 0, lineNumber = 0;
+    std::string              line;
+    while (std::getline(in, line)) {
+        ++lineNumber;
+        size_t first = line.find_first_not_of(" \t\r");
+        if (first == std::string::npos || line[first] == '#') continue;
+        line = line.substr(first, line.find_last_not_of(" \t\r") - first + 1);
+
+        // 没有指定分支时先留空，验证前查询仓库的默认分支
+        Yume::RepositoryEntry entry;
+        size_t                slash = line.find('/');
+        size_t                at    = line.find('@', slash == std::string::npos ? 0 : slash);
+        entry.branch                = at == std::string::npos ? "" : line.substr(at + 1);
+        if (slash != std::string::npos) {
+            entry.owner = line.substr(0, slash);
+            entry.repo  = line.substr(slash + 1, at == std::string::npos ? at : at - slash - 1);
+        }
+        if (entry.owner.empty() || entry.repo.empty() || (at != std::string::npos && entry.branch.empty())
+            || entry.repo.find('/') != std::string::npos) {
+            std::cerr << "第 " << lineNumber << " 行格式无效，应为 owner/repo[@branch]: " << line << std::endl;
+            ++invalid;
+            continue;
+        }
+        if (setConfig.repositories().contains(entry.owner, entry.repo)
+            || store.contains(entry.owner, entry.repo)) {
+            ++existing;
+            continue;
+        }
+        candidates.add(std::move(entry)); // 文件内重复的仓库以第一条为准
+    }
+
+    if (candidates.empty()) {
+        std::cout << "没有需要导入的新仓库（已存在 " << existing << " 个，格式无效 " << invalid << " 个）"
+                  << std::endl;
+        return invalid == 0;
+    }
+
+    std::cout << "正在验证 " << candidates.size() << " 个仓库..." << std::endl;
+    Yume::GitHubAPI api("", configPath);
+    auto            reason = [](long status, char const* missing) -> std::string {
+        return status == 404 ? missing : status == 0 ? "请求失败" : "HTTP " + std::to_string(status);
+    };
+
+    // 没有指定分支的仓库使用其默认分支（不一定是main）
+    std::vector<Yume::RepositoryEntry>               pending;
+    std::vector<std::pair<std::string, std::string>> unbranched;
+    size_t                                           failed = 0;
+    for (auto const& entry : candidates.entries())
+        if (entry.branch.empty()) unbranched.emplace_back(entry.owner, entry.repo);
+    auto defaults = api.getDefaultBranches(unbranched);
+    for (size_t i = 0, next = 0; i < candidates.size(); ++i) {
+        Yume::RepositoryEntry entry = candidates.entries()[i];
+        if (entry.branch.empty()) {
+            auto const& found = defaults[next++];
+            if (found.branch.empty()) {
+                std::cerr << "跳过 " << entry.fullName() << ": " << reason(found.status, "仓库不存在")
+                          << std::endl;
+                ++failed;
+                continue;
+            }
+            entry.branch = found.branch;
+        }
+        pending.push_back(std::move(entry));
+    }
+
+    std::vector<std::tuple<std::string, std::string, std::string>> branches;
+    branches.reserve(pending.size());
+    for (auto const& entry : pending) branches.emplace_back(entry.owner, entry.repo, entry.branch);
+    auto heads = api.getBranchHeads(branches);
+
+    std::vector<Yume::RepositoryEntry> verified;
+    std::vector<std::string>           shas;
+    for (size_t i = 0; i < heads.size(); ++i) {
+        auto const& entry = pending[i];
+        if (heads[i].sha.empty()) {
+            std::cerr << "跳过 " << entry.fullName() << "@" << entry.branch << ": "
+                      << reason(heads[i].status, "仓库或分支不存在") << std::endl;
+            ++failed;
+            continue;
+        }
+        verified.push_back(entry);
+        shas.push_back(heads[i].sha);
+    }
+
+    if (!verified.empty()) {
+        // 已迁移到分片存储时写入存储，否则写入config.json；两者都只写一次
+        size_t added = store.available() ? store.addAll(verified) : setConfig.addRepositories(verified);
+        if (added != verified.size()) {
+            std::cerr << "写入订阅失败，未导入任何仓库" << std::endl;
+            return false;
+        }
+        Yume::StateJournal state(Yume::StateJournal::directoryFor(configPath));
+        for (size_t i = 0; i < verified.size(); ++i)
+            state.setLastSha(Yume::StateJournal::key(verified[i].owner, verified[i].repo), shas[i]);
+        state.sync();
+    }
+
+    std::cout << "导入完成: 新增 " << verified.size() << " 个，已存在 " << existing << " 个，验证失败 "
+              << failed << " 个，格式无效 " << invalid << " 个" << std::endl;
+    return failed == 0 && invalid == 0;
+}
+
+// 从本地历史查询提交；since可以是日期（2025-05-30）、ISO时间或相对时间（7d、12h）
+bool showHistory(std::string const& configPath, std::string const& owner, std::string const& repo,
+                 std::string const& since) {
+    int64_t sinceTime = 0;
+    if (!since.empty()) {
+        char unit = since.back();
+        if ((unit == 'd' || unit == 'h') && since.size() > 1
+            && since.find_first_not_of("0123456789") == since.size() - 1) {
+            int64_t amount = 0;
+            auto [end, ec] = std::from_chars(since.data(), since.data() + since.size() - 1, amount);
+            if (ec != std::errc()) {
+                std::cerr << "相对时间超出范围: " << since << std::endl;
+                return false;
+            }
+            int64_t scale = unit == 'd' ? 86400 : 3600;
+            int64_t now   = std::chrono::duration_cast<std::chrono::seconds>(
+                              std::chrono::system_clock::now().time_since_epoch())
+                              .count();
+            // 早于1970年时等同于查询全部历史
+            sinceTime = amount > now / scale ? 0 : now - amount * scale;
+        } else {
+            sinceTime = Yume::HistoryStore::parseTime(since);
+            if (sinceTime == 0) {
+                std::cerr << "无法解析时间: " << since << "（支持 2025-05-30、2025-05-30T08:00:00、7d、12h）"
+                          << std::endl;
+                return false;
+            }
+        }
+    }
+
+    // 只读打开，监控进程可能正在写入；分片模式下仓库可能先后由多个工作进程记录
+    std::vector<Yume::HistoryRecord> records;
+    std::set<std::string>            seen;
+    for (auto const& directory : Yume::HistoryStore::directoriesFor(configPath)) {
+        Yume::HistoryStore history(directory, true);
+        for (auto& record : history.query(Yume::StateJournal::key(owner, repo), sinceTime))
+            if (seen.insert(record.sha).second) records.push_back(std::move(record));
+    }
+    auto newer = [](Yume::HistoryRecord const& a, Yume::HistoryRecord const& b) {
+        return a.time > b.time;
+    };
+    std::stable_sort(records.begin(), records.end(), newer);
+    if (records.empty()) {
+        std::cout << "本地历史中没有 " << owner << "/" << repo << " 的提交记录" << std::endl;
+        return true;
+    }
+
+    std::cout << owner << "/" << repo << " 的提交历史（" << records.size() << " 条）:" << std::endl;
+    std::cout << "--------------------------------------" << std::endl;
+    for (auto const& record : records) {
+        std::string title = record.message.substr(0, record.message.find('\n'));
+        std::cout << record.date << "  " << record.sha.substr(0, 7) << "  " << record.author << "  "
+                  << title << std::endl;
+    }
+    return true;
 }
 
 int main(int argc, char* argv[]) {
     // 设置信号处理
     std::signal(SIGINT, signalHandler);
     std::signal(SIGTERM, signalHandler);
+#ifndef YUMECARD_PLATFORM_WINDOWS
+    // 截图任务通过管道写入node进程，子进程提前退出时不应终止本程序
+    std::signal(SIGPIPE, SIG_IGN);
+#endif
 
     // 解析命令行参数
     auto [config, args] = parseArguments(argc, argv);
@@ -215,10 +576,43 @@ int main(int argc, char* argv[]) {
         std::string      owner  = args[1];
         std::string      repo   = args[2];
         std::string      branch = (args.size() >= 4) ? args[3] : "main";
+
+        // 监控进程运行时由它添加并立即获取最新提交，新仓库直接排入其检查计划
+        nlohmann::json request = {
+            {"command",  "add"},
+            {  "owner",  owner},
+            {   "repo",   repo},
+            { "branch", branch}
+        };
+        if (auto response = requestMonitor(config, request, std::chrono::seconds(60))) {
+            if (!response->value("ok", false)) {
+                std::cerr << "错误: " << response->value("error", "未知错误") << std::endl;
+                return 1;
+            }
+            if (!response->value("added", false)) {
+                std::cout << "仓库 " << owner << "/" << repo << " 已在订阅列表中" << std::endl;
+                return 0;
+            }
+            std::cout << "已添加仓库 " << owner << "/" << repo << " (分支: " << branch << ")，"
+                      << "已加入运行中的监控" << std::endl;
+            return 0;
+        }
+
         Yume::Set_config set_config(
             githubApi.m_config,
             config.getConfigPath()); // m_config is public in GitHubAPI or has a getter
-        set_config.addRepository(owner, repo, branch);
+        Yume::SubscriptionStore store(Yume::SubscriptionStore::directoryFor(config.getConfigPath()));
+        Yume::RepositoryEntry   entry;
+        entry.owner  = owner;
+        entry.repo   = repo;
+        entry.branch = branch;
+        // 已迁移到分片存储时新仓库写入存储，只重写一个分片和索引
+        bool added = store.available() && !set_config.repositories().contains(owner, repo)
+                       ? store.add(entry)
+                       : set_config.addRepository(owner, repo, branch);
+        if (added)
+            std::cout << "已添加仓库 " << owner << "/" << repo << " (分支: " << branch << ")" << std::endl;
+        else std::cout << "仓库 " << owner << "/" << repo << " 已在订阅列表中" << std::endl;
     } else if (command == "check" && args.size() >= 3) {
         if (args.size() < 3) {
             std::cerr << "错误: check命令需要owner和repo参数" << std::endl;
@@ -228,10 +622,28 @@ int main(int argc, char* argv[]) {
 
         std::string owner = args[1];
         std::string repo  = args[2];
-
-        Yume::GitHubSubscriber subscriber(config.getConfigPath(), config.styleDir, config.outputDir);
         std::cout << "检查仓库 " << owner << "/" << repo << " 的更新..." << std::endl;
-        auto newCommits = subscriber.checkRepositoryUpdates(owner, repo);
+
+        // 监控进程运行时由它优先检查并生成卡片；未订阅或不归该进程的仓库仍在本地检查
+        Yume::CommitBatch newCommits;
+        nlohmann::json    request = {
+            {"command", "check"},
+            {  "owner",   owner},
+            {   "repo",    repo}
+        };
+        auto timeout  = Yume::GitHubSubscriber::kControlCheckTimeout + std::chrono::seconds(30);
+        auto response = requestMonitor(config, request, timeout);
+        if (response && !response->value("local", false)) {
+            if (!response->value("ok", false)) {
+                std::cerr << "错误: " << response->value("error", "未知错误") << std::endl;
+                return 1;
+            }
+            std::cout << "已由运行中的监控进程检查" << std::endl;
+            newCommits = Yume::CommitBatch::fromJson((*response)["commits"]);
+        } else {
+            Yume::GitHubSubscriber subscriber(config.getConfigPath(), config.styleDir, config.outputDir);
+            newCommits = subscriber.checkRepositoryUpdates(owner, repo);
+        }
 
         if (newCommits.empty()) {
             std::cout << "没有新的commits。" << std::endl;
@@ -245,7 +657,13 @@ int main(int argc, char* argv[]) {
     } else if (command == "monitor") {
         unsigned int interval = (args.size() > 1) ? std::stoi(args[1]) : 10;
 
-        Yume::GitHubSubscriber subscriber(config.getConfigPath(), config.styleDir, config.outputDir);
+        if (!config.workerId.empty() && !Yume::ShardCoordinator::validId(config.workerId)) {
+            std::cerr << "错误: 工作进程ID只能包含字母、数字、'-' 和 '_'" << std::endl;
+            return 1;
+        }
+        Yume::GitHubSubscriber subscriber(config.getConfigPath(), config.styleDir, config.outputDir,
+                                          config.workerId);
+        if (!subscriber.joinCluster()) return 1;
         std::cout << "开始监控所有仓库，间隔 " << interval << " 分钟..." << std::endl;
         std::cout << "使用配置目录: " << config.configDir << std::endl;
         std::cout << "使用样式目录: " << config.styleDir << std::endl;
@@ -253,14 +671,16 @@ int main(int argc, char* argv[]) {
         std::cout << "按Ctrl+C终止监控" << std::endl;
 
         // 开始定期检查任务
-        std::thread monitorThread([&subscriber, interval]() { subscriber.startPeriodicCheck(interval); });
+        std::jthread monitorThread([&subscriber, interval](std::stop_token stop) {
+            subscriber.startPeriodicCheck(interval, stop);
+        });
 
         // 主线程等待直到收到终止信号
-        while (gRunning) std::this_thread::sleep_for(std::chrono::seconds(1));
+        while (gRunning) std::this_thread::sleep_for(std::chrono::milliseconds(200));
 
-        // 等待监控线程完成（实际上不会完成，因为它是一个无限循环）
-        // 这里只是为了正确地分离线程
-        monitorThread.detach();
+        // 请求监控线程停止，等待其完成进行中的检查并保存检查队列
+        monitorThread.request_stop();
+        monitorThread.join();
 
         std::cout << "程序已终止" << std::endl;
         return 0;
@@ -275,8 +695,19 @@ int main(int argc, char* argv[]) {
         if (setGitHubToken(config.getConfigPath(), token)) return 0;
         else return 1;
     } else if (command == "list") {
-        listRepositories(config.getConfigPath());
+        if (!listMonitorRepositories(config)) listRepositories(config.getConfigPath());
         return 0;
+    } else if (command == "status") {
+        return showMonitorStatus(config) ? 0 : 1;
+    } else if (command == "history" && args.size() >= 3) {
+        std::string since;
+        for (size_t i = 3; i + 1 < args.size(); ++i)
+            if (args[i] == "--since") since = args[i + 1];
+        return showHistory(config.getConfigPath(), args[1], args[2], since) ? 0 : 1;
+    } else if (command == "import") {
+        return importRepositories(config.getConfigPath(), args.size() >= 2 ? args[1] : "-") ? 0 : 1;
+    } else if (command == "migrate-store") {
+        return migrateSubscriptionStore(config.getConfigPath()) ? 0 : 1;
     } else if (command == "test-screenshot") { // New command handling
         // 使用 GitHubSubscriber 的测试截图功能，生成包含测试数据的截图
         Yume::GitHubSubscriber subscriber(config.getConfigPath(), config.styleDir, config.outputDir);
@@ -291,6 +722,13 @@ int main(int argc, char* argv[]) {
             std::cerr << "测试截图生成失败!" << std::endl;
             return 1;
         }
+    } else if (command == "prescale-backgrounds") {
+        return prescaleBackgrounds(config.getConfigPath(), screenshotManager, config.styleDir) ? 0 : 1;
+    } else if (command == "bundle-assets") {
+        Yume::AssetBundler bundler(config.styleDir);
+        return bundler.bundle() ? 0 : 1;
+    } else if (command == "export-theme") {
+        return screenshotManager.theme().exportDefaults() ? 0 : 1;
     } else if (command == "system-info") {
         systemInfoManager.displaySystemInfo(); // Corrected: Call method on the instance
     } else if (command == "diagnostic" && args.size() >= 2) {